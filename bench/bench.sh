@@ -4,7 +4,7 @@ set -euo pipefail
 usage() {
   cat <<'EOF'
 Usage:
-  ./bench/bench.sh --width W --height H --steps S --seed N --history-cap C
+  ./bench/bench.sh --width W --height H --steps S --seed N --history-cap C [--history-mem SIZE]
 
 Exemple:
   ./bench/bench.sh --width 512 --height 512 --steps 2000 --seed 42 --history-cap 512
@@ -16,6 +16,7 @@ HEIGHT=""
 STEPS=""
 SEED=""
 HCAP=""
+HMEM=""
 
 while [[ $# -gt 0 ]]; do
   case "$1" in
@@ -24,6 +25,7 @@ while [[ $# -gt 0 ]]; do
     --steps) STEPS="${2:-}"; shift 2;;
     --seed) SEED="${2:-}"; shift 2;;
     --history-cap) HCAP="${2:-}"; shift 2;;
+    --history-mem) HMEM="${2:-}"; shift 2;;
     -h|--help) usage; exit 0;;
     *) echo "Argument inconnu: $1" >&2; usage; exit 2;;
   esac
@@ -42,6 +44,9 @@ make -C projet-ringbuffer clean >/dev/null
 make -C projet-ringbuffer bench >/dev/null
 
 CMD_ARGS=(--width "$WIDTH" --height "$HEIGHT" --steps "$STEPS" --seed "$SEED" --history-cap "$HCAP")
+if [[ -n "$HMEM" ]]; then
+  CMD_ARGS+=(--history-mem "$HMEM")
+fi
 
 echo "== Run =="
 OUT_LIST="$(./projet-listechainee/bin/life_bench "${CMD_ARGS[@]}")"
@@ -68,10 +73,16 @@ T_LIST="$(get_field "$OUT_LIST" "total_s")"
 T_RING="$(get_field "$OUT_RING" "total_s")"
 NS_LIST="$(get_field "$OUT_LIST" "ns_per_step")"
 NS_RING="$(get_field "$OUT_RING" "ns_per_step")"
+AL_LIST="$(get_field "$OUT_LIST" "push_allocs")"
+AL_RING="$(get_field "$OUT_RING" "push_allocs")"
+CAP_LIST="$(get_field "$OUT_LIST" "history_cap")"
+CAP_RING="$(get_field "$OUT_RING" "history_cap")"
+MB_LIST="$(awk -v b="$(get_field "$OUT_LIST" "history_peak_bytes")" 'BEGIN{printf "%.1f", b / 1e6}')"
+MB_RING="$(awk -v b="$(get_field "$OUT_RING" "history_peak_bytes")" 'BEGIN{printf "%.1f", b / 1e6}')"
 
 echo "== Résumé =="
-printf "listechainee: total_s=%s  steps/s=%s  ns/step=%s\n" "$T_LIST" "$SPS_LIST" "$NS_LIST"
-printf "ringbuffer:   total_s=%s  steps/s=%s  ns/step=%s\n" "$T_RING" "$SPS_RING" "$NS_RING"
+printf "listechainee: total_s=%s  steps/s=%s  ns/step=%s  allocs/step=%s  cap=%s  pic=%s Mo\n" "$T_LIST" "$SPS_LIST" "$NS_LIST" "$AL_LIST" "$CAP_LIST" "$MB_LIST"
+printf "ringbuffer:   total_s=%s  steps/s=%s  ns/step=%s  allocs/step=%s  cap=%s  pic=%s Mo\n" "$T_RING" "$SPS_RING" "$NS_RING" "$AL_RING" "$CAP_RING" "$MB_RING"
 
 WINNER="$(awk -v a="$SPS_LIST" -v b="$SPS_RING" 'BEGIN{print (b>a) ? "ringbuffer" : "listechainee"}')"
 echo "Gagnant (steps/s): $WINNER"
@@ -0,0 +1,45 @@
+#ifndef BITGRID_H
+#define BITGRID_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "grid.h"
+
+/*
+ * Bit-packed grid: 64 cells per uint64_t word.
+ * - words: words per row (rows padded to whole words)
+ * - bits[y*words + (x >> 6)], bit (x & 63) holds cell (x,y)
+ * Padding bits beyond w are always 0.
+ */
+typedef struct BitGrid {
+  int w;
+  int h;
+  int words;
+  uint64_t *bits;
+} BitGrid;
+
+/* Allocates a w*h packed grid, initialized to 0. */
+bool bitgrid_create(BitGrid *b, int w, int h);
+
+/* Frees the internal buffer (does not free the BitGrid pointer itself). */
+void bitgrid_free(BitGrid *b);
+
+/* Packs g into b. b must be allocated with the same dimensions as g. */
+bool bitgrid_from_grid(BitGrid *b, const Grid *g);
+
+/* Unpacks b into g. g must be allocated with the same dimensions as b. */
+bool bitgrid_to_grid(const BitGrid *b, Grid *g);
+
+/*
+ * Computes the next generation from cur into next (boundary: life_boundary()).
+ * Neighbor counts are computed 64 cells at a time with bitwise full/half adders.
+ * next must be allocated with the same dimensions as cur.
+ */
+void bitgrid_step(const BitGrid *cur, BitGrid *next);
+
+/* Same as bitgrid_step, restricted to rows [y0, y1). */
+void bitgrid_step_rows(const BitGrid *cur, BitGrid *next, int y0, int y1);
+
+#endif /* BITGRID_H */
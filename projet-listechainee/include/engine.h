@@ -0,0 +1,184 @@
+#ifndef ENGINE_H
+#define ENGINE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "bitgrid.h"
+#include "chunked.h"
+#include "cycle.h"
+#include "grid.h"
+#include "hashlife.h"
+#include "life.h"
+#include "life_active.h"
+#include "life_pool.h"
+#include "life_tiled.h"
+#include "life_wavefront.h"
+#include "sparse.h"
+
+/*
+ * Stepping engines shared by batch mode (main.c) and life_bench.
+ * - ENGINE_BYTE: life_step on the uint8_t grid (reference)
+ * - ENGINE_PACKED: bitgrid_step on a 64-cells-per-word copy
+ * - ENGINE_TILED: life_tiled_pass, --tile-gens generations per pass over
+ *   --tile sized blocks (temporal blocking; engine_step does one generation)
+ * - ENGINE_ACTIVE: life_active_step, only the --tile sized blocks next to a
+ *   block that changed during the previous generation are recomputed
+ * - ENGINE_HASHLIFE: memoized quadtree (hashlife.h) on an unbounded plane, for
+ *   huge --steps; the output is the input's window (dead boundary only)
+ * - ENGINE_SPARSE: list of live cells (sparse.h), cost proportional to the
+ *   population; single-threaded
+ * - ENGINE_CHUNKED: unbounded plane of 64x64 chunks (chunked.h) allocated and
+ *   released with the activity; engine_run crops g to the live bounding box
+ *   (dead boundary only)
+ * - ENGINE_WAVEFRONT: life_wavefront_pass, --pipeline-depth generations in
+ *   flight per pass, each stage trailing the previous one by a few rows (dead
+ *   boundary only; engine_step does one generation)
+ * The byte kernel (scalar or SIMD) is chosen with --kernel (default: auto).
+ * With --threads N > 1, all engines step row bands on a persistent LifePool;
+ * the tiled and active engines schedule tiles as tasks instead (--schedule
+ * steal|static, work stealing by default).
+ * --numa pins the pool threads (one CPU each, consecutive threads on the same
+ * node) and places the grids the byte and packed engines step so that each
+ * row band's pages sit on the node of the thread stepping it.
+ * --pages thp|hugetlb backs the large grids with 2 MiB pages (grid.h); the
+ * caller applies it with grid_set_pages before allocating its grids.
+ * --boundary dead|torus selects the boundary rule of every engine, --rule the
+ * cell rule (B3/S23 by default).
+ * --cycle-window N (batch mode) hashes every 16th generation (every pass for
+ * tiled and wavefront) and, once a state comes back, measures its period and skips the rest
+ * of the run modulo it (cycle.h); periods up to N are found. hashlife and
+ * chunked do not check.
+ */
+typedef enum EngineKind {
+  ENGINE_BYTE = 0,
+  ENGINE_PACKED,
+  ENGINE_TILED,
+  ENGINE_ACTIVE,
+  ENGINE_HASHLIFE,
+  ENGINE_SPARSE,
+  ENGINE_CHUNKED,
+  ENGINE_WAVEFRONT
+} EngineKind;
+
+typedef struct EngineOptions {
+  EngineKind kind;
+  LifeKernel kernel;
+  int threads;
+  LifeBoundary boundary;
+  int tile;      /* tiled/active engines: tile side in cells (0 => engine default) */
+  int tile_gens; /* tiled engine: generations per pass */
+  int pipeline_depth; /* wavefront engine: generations per pass */
+  LifePoolSchedule schedule; /* tile tasks on the pool */
+  bool numa;           /* --numa: pinned threads, node-local row bands */
+  GridPages pages;     /* --pages: huge pages for the large grids (grid_set_pages) */
+  size_t hashlife_mem; /* hashlife engine: node store cap in bytes */
+  int cycle_window;    /* longest period detected (0 = no detection) */
+  LifeRule rule;       /* --rule (default B3/S23) */
+} EngineOptions;
+
+typedef struct Engine {
+  EngineOptions opt;
+  int w;
+  int h;
+  BitGrid pa; /* packed engine: current generation */
+  BitGrid pb; /* packed engine: next generation */
+  const uint8_t *pa_cells; /* packed engine: grid pa was last unpacked to, unchanged since (NULL: pa is stale) */
+  uint64_t convert_ns;     /* packed engine: time spent packing and unpacking grids */
+  LifePool pool;
+  LifeTiled tiled; /* tiled engine: per-band local buffers */
+  LifeActive active; /* active engine: per-tile change flags */
+  HashLife hl;       /* hashlife engine */
+  SparseLife sparse; /* sparse engine */
+  ChunkedWorld chunked; /* chunked engine */
+  LifeWavefront wave;   /* wavefront engine: stage buffers */
+  CycleDetector cycle;  /* --cycle-window > 0 */
+} Engine;
+
+void engine_options_default(EngineOptions *o);
+
+/*
+ * Parses argv[*i] if it is an engine option (--engine, --kernel, --threads, --boundary,
+ * --tile, --tile-gens, --pipeline-depth, --schedule, --numa, --pages, --hashlife-mem,
+ * --cycle-window, --rule).
+ * Returns 1 if consumed (and advances *i past its value), 0 if argv[*i] is not
+ * an engine option, -1 if the value is invalid.
+ */
+int engine_parse_arg(EngineOptions *o, int argc, char **argv, int *i);
+
+/* Usage fragment for the engine options. */
+const char *engine_usage(void);
+
+const char *engine_kind_name(EngineKind k);
+
+/* False if engine k cannot simulate boundary b (unbounded engines: dead only). */
+bool engine_supports_boundary(EngineKind k, LifeBoundary b);
+
+/*
+ * Applies the process-wide life settings (kernel, boundary, rule) of opt.
+ * Returns false if the kernel is not supported by the CPU.
+ */
+bool engine_configure(const EngineOptions *opt);
+
+/* Prepares the engine for w*h grids (fails if the requested kernel is unsupported). */
+bool engine_init(Engine *e, const EngineOptions *opt, int w, int h);
+void engine_free(Engine *e);
+
+/*
+ * Computes one generation from cur into next (same dimensions as the engine).
+ * cur must have an up-to-date halo (see life_refresh_halo); next gets one.
+ * The active engine expects each cur to follow the previous call's next. The
+ * packed engine keeps that next packed, and does not pack cur again when it is
+ * that grid: call engine_invalidate when it may have changed in between.
+ */
+bool engine_step(Engine *e, const Grid *cur, Grid *next);
+
+/*
+ * Forgets the packed copy of the last next (packed engine; no-op otherwise).
+ * To be called when the caller changed that grid or may step from another
+ * state held in the same buffer: edits, history moves (back, forward, seek),
+ * reuse of a history slot.
+ */
+void engine_invalidate(Engine *e);
+
+/*
+ * Advances g by steps generations in place (batch mode). The chunked engine
+ * replaces g with the bounding box of the live cells instead (same halo width).
+ */
+bool engine_run(Engine *e, Grid *g, uint64_t steps);
+
+/*
+ * Feeds generation gen of a timeline stepped with engine_step to the cycle
+ * detector (gen 0 starts a new timeline). Returns true when the state repeats
+ * an earlier one: see engine_cycle. No-op without --cycle-window.
+ */
+bool engine_observe(Engine *e, const Grid *g, uint64_t gen);
+
+/*
+ * Period of the cycle found by the last engine_run or engine_observe timeline,
+ * and the generation where it was measured. Returns false if none was found.
+ */
+bool engine_cycle(const Engine *e, uint64_t *period, uint64_t *start);
+
+/*
+ * --numa: zeroes g (freshly allocated, engine dimensions) band by band from the
+ * pool threads, so that its rows are placed like the engine's own grids. No-op
+ * otherwise.
+ */
+void engine_place(Engine *e, Grid *g);
+
+/* Number of NUMA nodes the pool threads run on (1 without --numa). */
+int engine_numa_nodes(const Engine *e);
+
+/*
+ * Bytes per second read and written by node since the last
+ * life_pool_reset_stats: the sum of its threads' rates, each over its own busy
+ * time (byte and packed engines, which step fixed row bands; 0 for the others).
+ */
+double engine_node_bandwidth(const Engine *e, int node);
+
+/* Fraction of the tiles skipped so far by the active engine (0 for the others). */
+double engine_tiles_skipped(const Engine *e);
+
+#endif /* ENGINE_H */
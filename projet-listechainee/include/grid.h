@@ -5,15 +5,58 @@
 #include <stddef.h>
 #include <stdint.h>
 
+/*
+ * Row-major byte grid, optionally surrounded by a ring of `pad` dead ghost cells
+ * (halo) so that kernels can read neighbors with plain pointer offsets.
+ * - cells points to cell (0,0); cell (x,y) is cells[y*stride + x] ∈ {0,1}
+ * - x in [-pad, w+pad) and y in [-pad, h+pad) are addressable; the halo stays 0
+ * - stride is w + 2*pad rounded up to GRID_ALIGN, and cells is GRID_ALIGN-aligned,
+ *   so every row starts on a cache line (and a whole number of vectors); the
+ *   bytes between a row's right halo and the next row's left halo are unused
+ */
+enum { GRID_ALIGN = 64 };
+
+/*
+ * Pages of the large grid buffers (from GRID_MAP_MIN bytes; smaller ones come
+ * from the aligned heap):
+ * - GRID_PAGES_DEFAULT: anonymous mapping, the kernel's transparent huge page policy
+ * - GRID_PAGES_THP: madvise(MADV_HUGEPAGE) on buffers of at least one 2 MiB page
+ * - GRID_PAGES_HUGETLB: MAP_HUGETLB (reserved 2 MiB pages), falling back to THP
+ *   when none are available
+ */
+typedef enum GridPages {
+  GRID_PAGES_DEFAULT = 0,
+  GRID_PAGES_THP,
+  GRID_PAGES_HUGETLB
+} GridPages;
+
+enum { GRID_MAP_MIN = 1 << 18 };
+
 typedef struct Grid {
   int w;
   int h;
-  uint8_t *cells; /* contiguous 1D: cells[y*w + x] ∈ {0,1} */
+  int stride;     /* bytes between two rows: w + 2*pad rounded up to GRID_ALIGN */
+  int pad;        /* halo width (0 = none) */
+  uint8_t *cells; /* first live cell */
+  uint8_t *mem;   /* allocation base (owns the buffer) */
+  size_t bytes;   /* size of mem */
+  bool mapped;    /* mem is an mmap (released with munmap) */
 } Grid;
 
-/* Allocates a w*h grid, initialized to 0. */
+/* Pages used by the grids allocated from now on (default: GRID_PAGES_DEFAULT). */
+void grid_set_pages(GridPages p);
+GridPages grid_pages(void);
+
+/* "default" | "thp" | "hugetlb". Returns false if unknown. */
+bool grid_parse_pages(const char *s, GridPages *out);
+const char *grid_pages_name(GridPages p);
+
+/* Allocates a w*h grid without halo, initialized to 0. */
 bool grid_create(Grid *g, int w, int h);
 
+/* Allocates a w*h grid with a dead halo of pad cells on each side, initialized to 0. */
+bool grid_create_padded(Grid *g, int w, int h, int pad);
+
 /* Frees the internal buffer (does not free the Grid pointer itself). */
 void grid_free(Grid *g);
 
@@ -29,16 +72,62 @@ uint8_t grid_get(const Grid *g, int x, int y);
 /* Write: ignored if out-of-bounds. v is normalized to {0,1}. */
 void grid_set(Grid *g, int x, int y, uint8_t v);
 
+/* Sets the halo to 0 (dead boundary). */
+void grid_clear_halo(Grid *g);
+
+/*
+ * Fills the halo with the wrapped edges (torus): the ghost column left of x=0
+ * holds column w-1, the ghost row above y=0 holds row h-1, corners included.
+ * No-op when pad == 0.
+ */
+void grid_wrap_halo(Grid *g);
+
+/* Row y (y in [0,h)), w cells. */
+static inline uint8_t *grid_row(const Grid *g, int y) {
+  return g->cells + (ptrdiff_t)y * g->stride;
+}
+
 /*
- * Resizes (via reallocation). Preserves the overlap (min(w), min(h)).
+ * Resizes (via reallocation). Preserves the overlap (min(w), min(h)) and the halo width.
  * New cells (when growing) are initialized to 0.
  */
 bool grid_resize(Grid *g, int new_w, int new_h);
 
-/* Heap clone. Returns NULL on error. */
+/* Changes the halo width (via reallocation), preserving every cell. */
+bool grid_set_pad(Grid *g, int pad);
+
+/* Copies the cells of src into dst (same w,h; layouts may differ). */
+bool grid_copy(Grid *dst, const Grid *src);
+
+/* Heap clone (same layout, pages of grid_pages()). Returns NULL on error. */
 Grid *grid_clone(const Grid *src);
 
 /* Swaps contents (w,h,cells). */
 void grid_swap(Grid *a, Grid *b);
 
+/*
+ * count buffers laid out for (w, h, pad) in one allocation (pages of
+ * grid_pages()), zeroed. grid_slab_view points a Grid at buffer i without
+ * giving it ownership: grid_free on a view only forgets the buffer.
+ */
+typedef struct GridSlab {
+  int w;
+  int h;
+  int pad;
+  size_t count;
+  size_t slot_bytes; /* distance between two buffers (multiple of GRID_ALIGN) */
+  size_t offset;     /* cell (0,0) within a buffer */
+  int stride;
+  uint8_t *mem;
+  size_t bytes;
+  bool mapped;
+} GridSlab;
+
+bool grid_slab_create(GridSlab *s, size_t count, int w, int h, int pad);
+void grid_slab_free(GridSlab *s);
+void grid_slab_view(const GridSlab *s, size_t i, Grid *out);
+
+/* slot_bytes of a slab laid out for (w, h, pad), 0 if invalid. */
+size_t grid_slab_slot_bytes(int w, int h, int pad);
+
 #endif /* GRID_H */
@@ -3,27 +3,74 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 
 #include "grid.h"
 
 typedef struct HistoryNode {
-  Grid *grid; /* snapshot (owned by the node) */
+  Grid grid; /* snapshot: view of a buffer of the node's block */
+  uint64_t gen; /* generation number (the initial grid is 0, kept across evictions) */
   struct HistoryNode *prev;
-  struct HistoryNode *next;
+  struct HistoryNode *next; /* also links the free nodes */
 } HistoryNode;
 
+/*
+ * Node pool: nodes come in blocks, each with a slab of as many grid buffers
+ * (grid.h), and go back to a freelist when evicted or cleared, buffer included.
+ * Blocks are only released by history_free, so a history that stopped growing
+ * neither allocates nor frees.
+ */
+typedef struct HistoryBlock {
+  struct HistoryBlock *next;
+  GridSlab slab;
+  size_t count;
+  HistoryNode nodes[];
+} HistoryBlock;
+
 typedef struct History {
   HistoryNode *head;
   HistoryNode *tail;
   HistoryNode *cur;
   size_t len;
   size_t cap; /* 0 = unlimited; otherwise keep at most cap snapshots (evict oldest) */
+  HistoryNode *pending; /* handed out by history_reserve, not linked yet */
+  HistoryNode *free_nodes;
+  HistoryBlock *blocks;
+  int w; /* layout of every snapshot (the initial grid's) */
+  int h;
+  int pad;
+  size_t allocs; /* heap allocations made so far (2 per block: nodes, slab) */
+  size_t nodes;  /* in all blocks */
+  size_t bytes;  /* held by the blocks (nodes and grid buffers) */
+  size_t peak_bytes;
+  /*
+   * Skip index: skip[skip_lo .. skip_len) are the linked nodes whose generation
+   * is a multiple of HISTORY_SKIP, in order, so history_seek walks fewer than
+   * HISTORY_SKIP nodes. skip_room entries are allocated.
+   */
+  HistoryNode **skip;
+  size_t skip_lo;
+  size_t skip_len;
+  size_t skip_room;
 } History;
 
+/* Generations between two entries of the skip index. */
+enum { HISTORY_SKIP = 64 };
+
 /* Initializes history with a copy of initial. */
 bool history_init(History *h, const Grid *initial, size_t cap);
 
-/* Frees all nodes and their grids. */
+/*
+ * Same, with a budget of mem bytes (0 => none): cap becomes the number of
+ * snapshots whose blocks fit in mem, at most cap if cap > 0. False if not
+ * even one snapshot fits.
+ */
+bool history_init_mem(History *h, const Grid *initial, size_t cap, size_t mem);
+
+/* "512M", "2G", "65536": bytes, binary suffixes K, M, G, T (non-zero). */
+bool history_parse_mem(const char *s, size_t *out);
+
+/* Frees all blocks (nodes and their grids). */
 void history_free(History *h);
 
 /* Returns the current grid (non-NULL if history is initialized). */
@@ -34,12 +81,28 @@ const Grid *history_current_const(const History *h);
 void history_clear_forward(History *h);
 
 /*
- * Pushes a new snapshot (clone of g) after cur.
+ * Pushes a new snapshot (copy of g, same w and h as the initial grid) after cur.
  * If cur is not at the end, clear_forward is applied.
  * If cap>0, evicts oldest snapshots to stay <= cap.
  */
 bool history_push(History *h, const Grid *g);
 
+/*
+ * Zero-copy push, for stepping straight into the history:
+ *   Grid *next = history_reserve(h);
+ *   life_step(history_current(h), next);
+ *   history_commit(h);
+ * history_reserve clears the forward states and returns the grid of a free,
+ * unlinked node (same layout as the current snapshot, contents undefined);
+ * history_commit appends it after cur and evicts the oldest snapshots beyond cap.
+ */
+Grid *history_reserve(History *h);
+bool history_commit(History *h);
+
+/* Bytes held by the history (blocks and skip index), and the highest value since history_init. */
+size_t history_bytes(const History *h);
+size_t history_peak_bytes(const History *h);
+
 bool history_can_back(const History *h);
 bool history_can_forward(const History *h);
 
@@ -47,4 +110,15 @@ bool history_can_forward(const History *h);
 bool history_back(History *h);
 bool history_forward(History *h);
 
+/* Generation of cur, and of the oldest and newest snapshots (head, tail). */
+uint64_t history_generation(const History *h);
+uint64_t history_first_generation(const History *h);
+uint64_t history_last_generation(const History *h);
+
+/*
+ * Makes generation gen current if it is stored (first..last), through the
+ * skip index; false otherwise.
+ */
+bool history_seek(History *h, uint64_t gen);
+
 #endif /* HISTORY_H */
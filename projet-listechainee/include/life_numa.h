@@ -0,0 +1,28 @@
+#ifndef LIFE_NUMA_H
+#define LIFE_NUMA_H
+
+#include <stdbool.h>
+
+/*
+ * NUMA topology (Linux sysfs, no libnuma): the nodes holding CPUs this process
+ * may run on, and their CPUs. Without sysfs node information the machine is
+ * seen as one node with every allowed CPU.
+ */
+
+enum { LIFE_NUMA_MAX_NODES = 64, LIFE_NUMA_MAX_CPUS = 1024 };
+
+typedef struct LifeNumaTopology {
+  int nnodes;
+  int node_id[LIFE_NUMA_MAX_NODES];    /* sysfs node number */
+  int first_cpu[LIFE_NUMA_MAX_NODES];  /* node n owns cpus[first_cpu[n] .. first_cpu[n] + ncpus[n]) */
+  int ncpus[LIFE_NUMA_MAX_NODES];
+  int cpus[LIFE_NUMA_MAX_CPUS];
+} LifeNumaTopology;
+
+/* Reads the topology once (later calls return the cached copy). */
+const LifeNumaTopology *life_numa_topology(void);
+
+/* Pins the calling thread to cpu (sched_setaffinity). */
+bool life_numa_pin_self(int cpu);
+
+#endif /* LIFE_NUMA_H */
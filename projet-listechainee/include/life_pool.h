@@ -0,0 +1,100 @@
+#ifndef LIFE_POOL_H
+#define LIFE_POOL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "grid.h"
+
+/* Job run by every thread of the pool on its band of rows [y0, y1). */
+typedef void (*LifePoolRowsFn)(void *ctx, int y0, int y1);
+
+/* Task job: runs task number task on pool thread worker (0 = calling thread). */
+typedef void (*LifePoolTaskFn)(void *ctx, int task, int worker);
+
+/*
+ * How life_pool_run_tasks shares tasks. STATIC: each thread runs a fixed
+ * contiguous range. STEAL: the same ranges seed per-thread Chase-Lev deques;
+ * a thread that runs out of work steals from the top of another one's deque.
+ */
+typedef enum LifePoolSchedule {
+  LIFE_SCHEDULE_STEAL = 0,
+  LIFE_SCHEDULE_STATIC
+} LifePoolSchedule;
+
+/* Threads, barriers and startup gate (defined in life_pool.c). */
+struct LifePoolSync;
+
+/*
+ * Persistent thread pool: nthreads-1 workers are created once and the calling
+ * thread takes band 0. Each job splits rows into nthreads contiguous bands and
+ * is framed by two barriers (start, done), so no thread is spawned per step.
+ */
+typedef struct LifePool {
+  int nthreads;
+  struct LifePoolSync *sync; /* NULL when nthreads <= 1 */
+  LifePoolRowsFn fn;         /* current job */
+  LifePoolTaskFn task_fn;    /* current job, task form (fn == NULL) */
+  void *ctx;
+  int rows;
+  bool quit;
+  LifePoolSchedule schedule; /* life_pool_run_tasks (default STEAL) */
+  uint64_t *busy_ns;         /* per thread: time spent in jobs since the last reset */
+  uint64_t *rows_done;       /* per thread: rows of band jobs run since the last reset */
+  int *node;                 /* per thread: NUMA node index (life_numa.h), NULL until pinned */
+} LifePool;
+
+/* nthreads <= 1 => no worker thread (jobs run on the caller). */
+bool life_pool_init(LifePool *p, int nthreads);
+void life_pool_free(LifePool *p);
+
+/* Runs fn on rows [0, rows) split into bands; returns when every band is done. */
+void life_pool_run(LifePool *p, LifePoolRowsFn fn, void *ctx, int rows);
+
+/*
+ * Runs fn on tasks [0, ntasks), scheduled with p->schedule; returns when every
+ * task is done. Meant for tiles whose cost varies a lot (skipped regions).
+ */
+void life_pool_run_tasks(LifePool *p, LifePoolTaskFn fn, void *ctx, int ntasks);
+
+const char *life_pool_schedule_name(LifePoolSchedule s);
+
+/* Parses "steal" or "static". */
+bool life_pool_parse_schedule(const char *s, LifePoolSchedule *out);
+
+/* Time thread index (0 = calling thread) spent running jobs since the last reset. */
+uint64_t life_pool_busy_ns(const LifePool *p, int index);
+
+/* Rows of band jobs (life_pool_run) run by thread index since the last reset. */
+uint64_t life_pool_rows_done(const LifePool *p, int index);
+
+/* Zeroes the busy time and row counters of every thread. */
+void life_pool_reset_stats(LifePool *p);
+
+/*
+ * NUMA mode: pins each thread (the caller included) to one CPU with
+ * sched_setaffinity. Consecutive threads share a node, so consecutive row bands
+ * do too. Returns false if a thread could not be pinned (it keeps running
+ * unpinned).
+ */
+bool life_pool_pin(LifePool *p);
+
+/* NUMA node index of thread index (0 when the pool is not pinned). */
+int life_pool_node(const LifePool *p, int index);
+
+/*
+ * Zeroes a freshly allocated buffer of rows rows of row_bytes each, every band
+ * from the thread that steps it (same split as life_pool_run over rows), so
+ * first-touch places each band's pages on that thread's node. Two buffers
+ * placed this way stay node-local for each band when swapped (grid_swap).
+ */
+void life_pool_place(LifePool *p, void *base, size_t row_bytes, int rows);
+
+/*
+ * One generation with life_step_rows on every band (bit-identical to life_step);
+ * the halo of next is refreshed once every band is done.
+ */
+void life_pool_step(LifePool *p, const Grid *cur, Grid *next);
+
+#endif /* LIFE_POOL_H */
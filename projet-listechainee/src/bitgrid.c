@@ -0,0 +1,312 @@
+#include "bitgrid.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "life.h"
+
+static bool bitgrid_words_ok(int w, int h, int *out_words, size_t *out_count) {
+  if (w <= 0 || h <= 0) {
+    return false;
+  }
+  size_t words = ((size_t)w + 63u) / 64u;
+  size_t hh = (size_t)h;
+  if (hh > (SIZE_MAX / sizeof(uint64_t)) / words) {
+    return false;
+  }
+  *out_words = (int)words;
+  *out_count = words * hh;
+  return true;
+}
+
+/* Mask of the valid bits of the last word of a row. */
+static uint64_t bitgrid_tail_mask(int w) {
+  int r = w & 63;
+  return (r == 0) ? ~0ull : ((1ull << r) - 1ull);
+}
+
+bool bitgrid_create(BitGrid *b, int w, int h) {
+  if (!b) {
+    return false;
+  }
+  int words = 0;
+  size_t count = 0;
+  if (!bitgrid_words_ok(w, h, &words, &count)) {
+    return false;
+  }
+
+  uint64_t *bits = (uint64_t *)calloc(count, sizeof(uint64_t));
+  if (!bits) {
+    return false;
+  }
+
+  b->w = w;
+  b->h = h;
+  b->words = words;
+  b->bits = bits;
+  return true;
+}
+
+void bitgrid_free(BitGrid *b) {
+  if (!b) {
+    return;
+  }
+  free(b->bits);
+  b->bits = NULL;
+  b->w = 0;
+  b->h = 0;
+  b->words = 0;
+}
+
+/* The 64 cells (0/1 bytes) at p, cell k in bit k. */
+static inline uint64_t pack64(const uint8_t *p) {
+#ifdef __SSE2__
+  uint64_t word = 0;
+  for (int j = 0; j < 4; j++) {
+    __m128i v = _mm_loadu_si128((const __m128i *)(p + 16 * j));
+    word |= (uint64_t)(uint32_t)_mm_movemask_epi8(_mm_slli_epi16(v, 7)) << (16 * j);
+  }
+  return word;
+#else
+  uint64_t word = 0;
+  for (int k = 0; k < 64; k++) {
+    word |= (uint64_t)(p[k] & 1u) << k;
+  }
+  return word;
+#endif
+}
+
+/* Bit k of the low byte of b spread to byte k (0/1) of the result, in memory order. */
+static inline uint64_t spread8(uint64_t b) {
+  b = (b | (b << 28)) & 0x0000000f0000000full;
+  b = (b | (b << 14)) & 0x0003000300030003ull;
+  b = (b | (b << 7)) & 0x0101010101010101ull;
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  b = __builtin_bswap64(b);
+#endif
+  return b;
+}
+
+bool bitgrid_from_grid(BitGrid *b, const Grid *g) {
+  if (!b || !b->bits || !g || !g->cells) {
+    return false;
+  }
+  if (b->w != g->w || b->h != g->h) {
+    return false;
+  }
+
+  const int full = g->w / 64;
+  for (int y = 0; y < g->h; y++) {
+    const uint8_t *src = grid_row(g, y);
+    uint64_t *dst = &b->bits[(size_t)y * (size_t)b->words];
+    for (int i = 0; i < full; i++) {
+      dst[i] = pack64(src + 64 * i);
+    }
+    if (full < b->words) {
+      int x0 = full * 64;
+      uint64_t word = 0;
+      for (int k = 0; x0 + k < g->w; k++) {
+        word |= (uint64_t)(src[x0 + k] & 1u) << k;
+      }
+      dst[full] = word;
+    }
+  }
+  return true;
+}
+
+bool bitgrid_to_grid(const BitGrid *b, Grid *g) {
+  if (!b || !b->bits || !g || !g->cells) {
+    return false;
+  }
+  if (b->w != g->w || b->h != g->h) {
+    return false;
+  }
+
+  const int full8 = b->w / 8;
+  for (int y = 0; y < b->h; y++) {
+    const uint64_t *src = &b->bits[(size_t)y * (size_t)b->words];
+    uint8_t *dst = grid_row(g, y);
+    for (int i = 0; i < full8; i++) {
+      const uint64_t cells = spread8(src[i >> 3] >> (8 * (i & 7)) & 0xffu);
+      memcpy(dst + 8 * i, &cells, sizeof(cells));
+    }
+    for (int x = full8 * 8; x < b->w; x++) {
+      dst[x] = (uint8_t)((src[x >> 6] >> (x & 63)) & 1u);
+    }
+  }
+  return true;
+}
+
+/* a + b + c -> (sum, carry), bit by bit. */
+static inline void full_add(uint64_t a, uint64_t b, uint64_t c, uint64_t *sum, uint64_t *carry) {
+  uint64_t t = a ^ b;
+  *sum = t ^ c;
+  *carry = (a & b) | (t & c);
+}
+
+/* a + b -> (sum, carry), bit by bit. */
+static inline void half_add(uint64_t a, uint64_t b, uint64_t *sum, uint64_t *carry) {
+  *sum = a ^ b;
+  *carry = a & b;
+}
+
+/*
+ * Word i of a row with its west/east shifted copies: bit x of *west holds cell
+ * x-1, bit x of *east holds cell x+1. win/ein are the bits entering from outside
+ * the row (0 for a dead boundary, the wrapped edge cell for a torus).
+ * row == NULL => dead row.
+ */
+static inline void row_word(const uint64_t *row, int i, int words, uint64_t win, uint64_t ein,
+                            uint64_t *c, uint64_t *west, uint64_t *east) {
+  if (!row) {
+    *c = 0;
+    *west = 0;
+    *east = 0;
+    return;
+  }
+  uint64_t v = row[i];
+  *c = v;
+  *west = (v << 1) | ((i > 0) ? (row[i - 1] >> 63) : win);
+  *east = (v >> 1) | ((i + 1 < words) ? (row[i + 1] << 63) : ein);
+}
+
+typedef struct RowRef {
+  const uint64_t *bits; /* NULL => dead row */
+  uint64_t win;         /* enters bit 0 of word 0 of the west copy */
+  uint64_t ein;         /* enters bit (w-1)&63 of the last word of the east copy */
+} RowRef;
+
+static RowRef row_ref(const BitGrid *g, int y, bool torus) {
+  RowRef r = {NULL, 0, 0};
+  if (y < 0 || y >= g->h) {
+    if (!torus) {
+      return r;
+    }
+    y = (y < 0) ? y + g->h : y - g->h;
+  }
+  r.bits = &g->bits[(size_t)y * (size_t)g->words];
+  if (torus) {
+    int last = g->w - 1;
+    r.win = (r.bits[last >> 6] >> (last & 63)) & 1u;
+    r.ein = (r.bits[0] & 1u) << (last & 63);
+  }
+  return r;
+}
+
+/* Next state of the 64 cells of word i of the middle row. */
+static inline uint64_t step_word(const RowRef *up, const RowRef *mid, const RowRef *down,
+                                 int i, int words) {
+  uint64_t u, u_w, u_e, m, m_w, m_e, d, d_w, d_e;
+  row_word(up->bits, i, words, up->win, up->ein, &u, &u_w, &u_e);
+  row_word(mid->bits, i, words, mid->win, mid->ein, &m, &m_w, &m_e);
+  row_word(down->bits, i, words, down->win, down->ein, &d, &d_w, &d_e);
+
+  /* Per-row partial sums (weights 1 and 2). */
+  uint64_t t0, t1, m0, m1, b0, b1;
+  full_add(u_w, u, u_e, &t0, &t1);
+  half_add(m_w, m_e, &m0, &m1);
+  full_add(d_w, d, d_e, &b0, &b1);
+
+  /* n = s0 + 2 * (t1 + m1 + b1 + c1) */
+  uint64_t s0, c1;
+  full_add(t0, m0, b0, &s0, &c1);
+
+  /* Twos count is exactly 1 <=> n is 2 or 3. */
+  uint64_t v0, v1;
+  full_add(t1, m1, b1, &v0, &v1);
+  uint64_t twos_is_one = (v0 ^ c1) & ~v1;
+
+  /* n == 3 (s0 set) => alive; n == 2 (s0 clear) => alive iff already alive. */
+  return twos_is_one & (s0 | m);
+}
+
+/* Masks (bit n set => rule applies to n neighbors) for step_word_rule. */
+typedef struct RuleMasks {
+  uint16_t birth;
+  uint16_t survive;
+} RuleMasks;
+
+/* Same as step_word for any rule: the 4 bits of n are rebuilt, then matched against each count of the rule. */
+static inline uint64_t step_word_rule(const RowRef *up, const RowRef *mid, const RowRef *down,
+                                      int i, int words, const RuleMasks *rm) {
+  uint64_t u, u_w, u_e, m, m_w, m_e, d, d_w, d_e;
+  row_word(up->bits, i, words, up->win, up->ein, &u, &u_w, &u_e);
+  row_word(mid->bits, i, words, mid->win, mid->ein, &m, &m_w, &m_e);
+  row_word(down->bits, i, words, down->win, down->ein, &d, &d_w, &d_e);
+
+  uint64_t t0, t1, m0, m1, b0, b1;
+  full_add(u_w, u, u_e, &t0, &t1);
+  half_add(m_w, m_e, &m0, &m1);
+  full_add(d_w, d, d_e, &b0, &b1);
+
+  /* n = s0 + 2 * (t1 + m1 + b1 + c1) = n0 + 2 n1 + 4 n2 + 8 n3 */
+  uint64_t s0, c1, v0, v1, w0, w1;
+  full_add(t0, m0, b0, &s0, &c1);
+  full_add(t1, m1, b1, &v0, &v1);
+  half_add(v0, c1, &w0, &w1);
+  const uint64_t nb[4] = {s0, w0, w1 ^ v1, w1 & v1};
+
+  uint64_t r = 0;
+  for (int k = 0; k <= 8; k++) {
+    const bool b = (rm->birth >> k) & 1u;
+    const bool sv = (rm->survive >> k) & 1u;
+    if (!b && !sv) {
+      continue;
+    }
+    uint64_t eq = ~(uint64_t)0;
+    for (int bit = 0; bit < 4; bit++) {
+      eq &= ((k >> bit) & 1) ? nb[bit] : ~nb[bit];
+    }
+    r |= eq & ((b && sv) ? ~(uint64_t)0 : (b ? ~m : m));
+  }
+  return r;
+}
+
+void bitgrid_step(const BitGrid *cur, BitGrid *next) {
+  if (!cur) {
+    return;
+  }
+  bitgrid_step_rows(cur, next, 0, cur->h);
+}
+
+void bitgrid_step_rows(const BitGrid *cur, BitGrid *next, int y0, int y1) {
+  if (!cur || !next || !cur->bits || !next->bits) {
+    return;
+  }
+  if (cur->w != next->w || cur->h != next->h) {
+    return;
+  }
+  if (y0 < 0) y0 = 0;
+  if (y1 > cur->h) y1 = cur->h;
+
+  const bool torus = (life_boundary() == LIFE_BOUNDARY_TORUS);
+  const LifeRule *rule = life_rule();
+  const bool conway = life_rule_is_conway(rule);
+  RuleMasks rm = {0, 0};
+  for (int k = 0; k <= 8; k++) {
+    rm.birth |= (uint16_t)(rule->birth[k] << k);
+    rm.survive |= (uint16_t)(rule->survive[k] << k);
+  }
+  int words = cur->words;
+  uint64_t tail = bitgrid_tail_mask(cur->w);
+  for (int y = y0; y < y1; y++) {
+    RowRef up = row_ref(cur, y - 1, torus);
+    RowRef mid = row_ref(cur, y, torus);
+    RowRef down = row_ref(cur, y + 1, torus);
+    uint64_t *out = &next->bits[(size_t)y * (size_t)words];
+    if (conway) {
+      for (int i = 0; i < words; i++) {
+        out[i] = step_word(&up, &mid, &down, i, words);
+      }
+    } else {
+      for (int i = 0; i < words; i++) {
+        out[i] = step_word_rule(&up, &mid, &down, i, words, &rm);
+      }
+    }
+    out[words - 1] &= tail;
+  }
+}
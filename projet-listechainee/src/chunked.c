@@ -0,0 +1,400 @@
+#include "chunked.h"
+
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "life.h"
+
+enum { CHUNK_STRIDE = CHUNK_SIDE + 2, CHUNK_MIN_TABLE = 256, CHUNK_MAX_SPARE = 256 };
+
+typedef struct Chunk {
+  int64_t cx;
+  int64_t cy;
+  struct Chunk *hnext; /* hash chain, or spare list */
+  size_t index;        /* position in ChunkedWorld.chunks */
+  bool alive;          /* the generation just computed has a live cell */
+  uint8_t buf[2][CHUNK_STRIDE * CHUNK_STRIDE];
+} Chunk;
+
+typedef struct ChunkStepJob {
+  ChunkedWorld *cw;
+} ChunkStepJob;
+
+static inline size_t chunk_hash(int64_t cx, int64_t cy) {
+  uint64_t h = (uint64_t)cx * 0x9e3779b97f4a7c15ull ^ (uint64_t)cy * 0xc2b2ae3d27d4eb4full;
+  h ^= h >> 31;
+  return (size_t)h;
+}
+
+/* Grid view of one generation of a chunk (pad 1, cells at (0, 0)). */
+static Grid chunk_view(Chunk *c, int gen) {
+  Grid v = {CHUNK_SIDE, CHUNK_SIDE, CHUNK_STRIDE, 1, c->buf[gen] + CHUNK_STRIDE + 1, NULL, 0, false};
+  return v;
+}
+
+static Chunk *chunk_find(const ChunkedWorld *cw, int64_t cx, int64_t cy) {
+  if (!cw->table_size) {
+    return NULL;
+  }
+  for (Chunk *c = cw->table[chunk_hash(cx, cy) & (cw->table_size - 1u)]; c; c = c->hnext) {
+    if (c->cx == cx && c->cy == cy) {
+      return c;
+    }
+  }
+  return NULL;
+}
+
+static bool table_resize(ChunkedWorld *cw, size_t size) {
+  Chunk **t = (Chunk **)calloc(size, sizeof(Chunk *));
+  if (!t) {
+    return false;
+  }
+  for (size_t i = 0; i < cw->count; i++) {
+    Chunk *c = cw->chunks[i];
+    size_t b = chunk_hash(c->cx, c->cy) & (size - 1u);
+    c->hnext = t[b];
+    t[b] = c;
+  }
+  free(cw->table);
+  cw->table = t;
+  cw->table_size = size;
+  return true;
+}
+
+/* Existing chunk (cx, cy), or a new one with an empty current generation. */
+static Chunk *chunk_get(ChunkedWorld *cw, int64_t cx, int64_t cy) {
+  Chunk *c = chunk_find(cw, cx, cy);
+  if (c) {
+    return c;
+  }
+  if (cw->count == cw->cap) {
+    size_t cap = cw->cap ? cw->cap * 2u : 64u;
+    Chunk **p = (Chunk **)realloc(cw->chunks, cap * sizeof(Chunk *));
+    if (!p) {
+      return NULL;
+    }
+    cw->chunks = p;
+    cw->cap = cap;
+  }
+  if (cw->count >= cw->table_size &&
+      !table_resize(cw, cw->table_size ? cw->table_size * 2u : (size_t)CHUNK_MIN_TABLE)) {
+    return NULL;
+  }
+  if (cw->spare) {
+    c = cw->spare;
+    cw->spare = c->hnext;
+    cw->nspare--;
+  } else {
+    c = (Chunk *)malloc(sizeof(Chunk));
+    if (!c) {
+      return NULL;
+    }
+  }
+  c->cx = cx;
+  c->cy = cy;
+  c->alive = false;
+  memset(c->buf[cw->gen], 0, sizeof(c->buf[0]));
+  size_t b = chunk_hash(cx, cy) & (cw->table_size - 1u);
+  c->hnext = cw->table[b];
+  cw->table[b] = c;
+  c->index = cw->count;
+  cw->chunks[cw->count++] = c;
+  return c;
+}
+
+static void chunk_release(ChunkedWorld *cw, Chunk *c) {
+  Chunk **pp = &cw->table[chunk_hash(c->cx, c->cy) & (cw->table_size - 1u)];
+  while (*pp != c) {
+    pp = &(*pp)->hnext;
+  }
+  *pp = c->hnext;
+  Chunk *last = cw->chunks[--cw->count];
+  cw->chunks[c->index] = last;
+  last->index = c->index;
+  if (cw->nspare < CHUNK_MAX_SPARE) {
+    c->hnext = cw->spare;
+    cw->spare = c;
+    cw->nspare++;
+  } else {
+    free(c);
+  }
+}
+
+bool chunked_init(ChunkedWorld *cw) {
+  if (!cw) {
+    return false;
+  }
+  memset(cw, 0, sizeof(*cw));
+  return true;
+}
+
+static void release_all(ChunkedWorld *cw) {
+  while (cw->count > 0) {
+    chunk_release(cw, cw->chunks[cw->count - 1u]);
+  }
+}
+
+void chunked_free(ChunkedWorld *cw) {
+  if (!cw) return;
+  release_all(cw);
+  while (cw->spare) {
+    Chunk *c = cw->spare;
+    cw->spare = c->hnext;
+    free(c);
+  }
+  free(cw->table);
+  free(cw->chunks);
+  memset(cw, 0, sizeof(*cw));
+}
+
+size_t chunked_count(const ChunkedWorld *cw) {
+  return cw ? cw->count : 0;
+}
+
+bool chunked_load(ChunkedWorld *cw, const Grid *g) {
+  if (!cw || !g || !g->cells) {
+    return false;
+  }
+  release_all(cw);
+  cw->gen = 0;
+  for (int y0 = 0; y0 < g->h; y0 += CHUNK_SIDE) {
+    const int rows = (g->h - y0 < CHUNK_SIDE) ? g->h - y0 : CHUNK_SIDE;
+    for (int x0 = 0; x0 < g->w; x0 += CHUNK_SIDE) {
+      const int cols = (g->w - x0 < CHUNK_SIDE) ? g->w - x0 : CHUNK_SIDE;
+      bool any = false;
+      for (int y = 0; y < rows && !any; y++) {
+        any = memchr(grid_row(g, y0 + y) + x0, 1, (size_t)cols) != NULL;
+      }
+      if (!any) {
+        continue;
+      }
+      Chunk *c = chunk_get(cw, x0 / CHUNK_SIDE, y0 / CHUNK_SIDE);
+      if (!c) {
+        return false;
+      }
+      Grid v = chunk_view(c, cw->gen);
+      for (int y = 0; y < rows; y++) {
+        memcpy(grid_row(&v, y), grid_row(g, y0 + y) + x0, (size_t)cols);
+      }
+    }
+  }
+  return true;
+}
+
+/* Allocates the neighbors that a live cell on the border of c could give birth in. */
+static bool grow_around(ChunkedWorld *cw, Chunk *c) {
+  const int last = CHUNK_SIDE - 1;
+  Grid v = chunk_view(c, cw->gen);
+  const uint8_t *top = grid_row(&v, 0);
+  const uint8_t *bottom = grid_row(&v, last);
+  bool left = false, right = false;
+  for (int y = 0; y < CHUNK_SIDE; y++) {
+    left |= grid_row(&v, y)[0] != 0;
+    right |= grid_row(&v, y)[last] != 0;
+  }
+  const bool up = memchr(top, 1, CHUNK_SIDE) != NULL;
+  const bool down = memchr(bottom, 1, CHUNK_SIDE) != NULL;
+  const int64_t cx = c->cx, cy = c->cy;
+  if (up && !chunk_get(cw, cx, cy - 1)) return false;
+  if (down && !chunk_get(cw, cx, cy + 1)) return false;
+  if (left && !chunk_get(cw, cx - 1, cy)) return false;
+  if (right && !chunk_get(cw, cx + 1, cy)) return false;
+  if (top[0] && !chunk_get(cw, cx - 1, cy - 1)) return false;
+  if (top[last] && !chunk_get(cw, cx + 1, cy - 1)) return false;
+  if (bottom[0] && !chunk_get(cw, cx - 1, cy + 1)) return false;
+  if (bottom[last] && !chunk_get(cw, cx + 1, cy + 1)) return false;
+  return true;
+}
+
+/* Fills the halo of generation gen of c from its 8 neighbors (missing => dead). */
+static void fill_halo(const ChunkedWorld *cw, Chunk *c, int gen) {
+  const int last = CHUNK_SIDE - 1;
+  Grid v = chunk_view(c, gen);
+  Chunk *n = chunk_find(cw, c->cx, c->cy - 1);
+  Chunk *s = chunk_find(cw, c->cx, c->cy + 1);
+  Chunk *w = chunk_find(cw, c->cx - 1, c->cy);
+  Chunk *e = chunk_find(cw, c->cx + 1, c->cy);
+  Chunk *nw = chunk_find(cw, c->cx - 1, c->cy - 1);
+  Chunk *ne = chunk_find(cw, c->cx + 1, c->cy - 1);
+  Chunk *sw = chunk_find(cw, c->cx - 1, c->cy + 1);
+  Chunk *se = chunk_find(cw, c->cx + 1, c->cy + 1);
+  uint8_t *above = grid_row(&v, -1);
+  uint8_t *below = grid_row(&v, CHUNK_SIDE);
+
+  if (n) {
+    Grid o = chunk_view(n, gen);
+    memcpy(above, grid_row(&o, last), CHUNK_SIDE);
+  } else {
+    memset(above, 0, CHUNK_SIDE);
+  }
+  if (s) {
+    Grid o = chunk_view(s, gen);
+    memcpy(below, grid_row(&o, 0), CHUNK_SIDE);
+  } else {
+    memset(below, 0, CHUNK_SIDE);
+  }
+  Grid wv = w ? chunk_view(w, gen) : v;
+  Grid ev = e ? chunk_view(e, gen) : v;
+  for (int y = 0; y < CHUNK_SIDE; y++) {
+    uint8_t *row = grid_row(&v, y);
+    row[-1] = w ? grid_row(&wv, y)[last] : 0u;
+    row[CHUNK_SIDE] = e ? grid_row(&ev, y)[0] : 0u;
+  }
+  if (nw) {
+    Grid o = chunk_view(nw, gen);
+    above[-1] = grid_row(&o, last)[last];
+  } else {
+    above[-1] = 0;
+  }
+  if (ne) {
+    Grid o = chunk_view(ne, gen);
+    above[CHUNK_SIDE] = grid_row(&o, last)[0];
+  } else {
+    above[CHUNK_SIDE] = 0;
+  }
+  if (sw) {
+    Grid o = chunk_view(sw, gen);
+    below[-1] = grid_row(&o, 0)[last];
+  } else {
+    below[-1] = 0;
+  }
+  if (se) {
+    Grid o = chunk_view(se, gen);
+    below[CHUNK_SIDE] = grid_row(&o, 0)[0];
+  } else {
+    below[CHUNK_SIDE] = 0;
+  }
+}
+
+static void step_chunks(void *ctx, int i0, int i1) {
+  ChunkStepJob *job = (ChunkStepJob *)ctx;
+  ChunkedWorld *cw = job->cw;
+  const int gen = cw->gen;
+  for (int i = i0; i < i1; i++) {
+    Chunk *c = cw->chunks[i];
+    fill_halo(cw, c, gen);
+    Grid cur = chunk_view(c, gen);
+    Grid next = chunk_view(c, gen ^ 1);
+    life_step_rect(&cur, &next, 0, 0, CHUNK_SIDE, CHUNK_SIDE);
+    bool alive = false;
+    for (int y = 0; y < CHUNK_SIDE && !alive; y++) {
+      alive = memchr(grid_row(&next, y), 1, CHUNK_SIDE) != NULL;
+    }
+    c->alive = alive;
+  }
+}
+
+static bool chunked_step(ChunkedWorld *cw, LifePool *pool) {
+  const size_t n = cw->count;
+  for (size_t i = 0; i < n; i++) {
+    if (!grow_around(cw, cw->chunks[i])) {
+      return false;
+    }
+  }
+  if (cw->count > INT_MAX) {
+    return false;
+  }
+  ChunkStepJob job = {cw};
+  if (pool) {
+    life_pool_run(pool, step_chunks, &job, (int)cw->count);
+  } else {
+    step_chunks(&job, 0, (int)cw->count);
+  }
+  cw->gen ^= 1;
+  for (size_t i = cw->count; i-- > 0;) {
+    if (!cw->chunks[i]->alive) {
+      chunk_release(cw, cw->chunks[i]);
+    }
+  }
+  return true;
+}
+
+bool chunked_advance(ChunkedWorld *cw, LifePool *pool, uint64_t steps) {
+  if (!cw) {
+    return false;
+  }
+  for (uint64_t i = 0; i < steps && cw->count > 0; i++) {
+    if (!chunked_step(cw, pool)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/* Copies the cells of every chunk that overlaps g, g's cell (0, 0) at world (ox, oy). */
+static void store_window(const ChunkedWorld *cw, Grid *g, int64_t ox, int64_t oy) {
+  for (size_t i = 0; i < cw->count; i++) {
+    Chunk *c = cw->chunks[i];
+    const int64_t x0 = c->cx * CHUNK_SIDE - ox;
+    const int64_t y0 = c->cy * CHUNK_SIDE - oy;
+    const int64_t xa = (x0 > 0) ? x0 : 0;
+    const int64_t xb = (x0 + CHUNK_SIDE < g->w) ? x0 + CHUNK_SIDE : g->w;
+    const int64_t ya = (y0 > 0) ? y0 : 0;
+    const int64_t yb = (y0 + CHUNK_SIDE < g->h) ? y0 + CHUNK_SIDE : g->h;
+    if (xa >= xb || ya >= yb) {
+      continue;
+    }
+    Grid v = chunk_view(c, cw->gen);
+    for (int64_t y = ya; y < yb; y++) {
+      memcpy(grid_row(g, (int)y) + xa, grid_row(&v, (int)(y - y0)) + (xa - x0), (size_t)(xb - xa));
+    }
+  }
+}
+
+bool chunked_store(const ChunkedWorld *cw, Grid *g) {
+  if (!cw || !g || !g->cells) {
+    return false;
+  }
+  grid_clear(g);
+  store_window(cw, g, 0, 0);
+  return true;
+}
+
+bool chunked_store_bbox(const ChunkedWorld *cw, Grid *g) {
+  if (!cw || !g) {
+    return false;
+  }
+  int64_t minx = INT64_MAX, miny = INT64_MAX, maxx = INT64_MIN, maxy = INT64_MIN;
+  for (size_t i = 0; i < cw->count; i++) {
+    Chunk *c = cw->chunks[i];
+    Grid v = chunk_view(c, cw->gen);
+    for (int y = 0; y < CHUNK_SIDE; y++) {
+      const uint8_t *row = grid_row(&v, y);
+      const uint8_t *first = (const uint8_t *)memchr(row, 1, CHUNK_SIDE);
+      if (!first) {
+        continue;
+      }
+      int lastx = CHUNK_SIDE - 1;
+      while (!row[lastx]) {
+        lastx--;
+      }
+      const int64_t wy = c->cy * CHUNK_SIDE + y;
+      const int64_t wx0 = c->cx * CHUNK_SIDE + (first - row);
+      const int64_t wx1 = c->cx * CHUNK_SIDE + lastx;
+      if (wy < miny) miny = wy;
+      if (wy > maxy) maxy = wy;
+      if (wx0 < minx) minx = wx0;
+      if (wx1 > maxx) maxx = wx1;
+    }
+  }
+
+  const int pad = g->pad;
+  Grid out = {0};
+  if (maxx < minx) {
+    if (!grid_create_padded(&out, 1, 1, pad)) {
+      return false;
+    }
+  } else {
+    if (maxx - minx >= INT_MAX || maxy - miny >= INT_MAX) {
+      return false;
+    }
+    if (!grid_create_padded(&out, (int)(maxx - minx + 1), (int)(maxy - miny + 1), pad)) {
+      return false;
+    }
+    store_window(cw, &out, minx, miny);
+  }
+  grid_free(g);
+  *g = out;
+  return true;
+}
@@ -0,0 +1,591 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "engine.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* Generations between two cycle detection samples (see cycle.h). */
+enum { ENGINE_CYCLE_STRIDE = 16 };
+
+static uint64_t now_ns(void) {
+  struct timespec ts;
+  (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+typedef struct PackedJob {
+  const BitGrid *cur;
+  BitGrid *next;
+} PackedJob;
+
+void engine_options_default(EngineOptions *o) {
+  if (!o) return;
+  o->kind = ENGINE_BYTE;
+  o->kernel = LIFE_KERNEL_AUTO;
+  o->threads = 1;
+  o->boundary = LIFE_BOUNDARY_DEAD;
+  o->tile = 0;
+  o->tile_gens = 16;
+  o->pipeline_depth = 4;
+  o->schedule = LIFE_SCHEDULE_STEAL;
+  o->numa = false;
+  o->pages = GRID_PAGES_DEFAULT;
+  o->hashlife_mem = 0;
+  o->cycle_window = 0;
+  o->rule = life_rule_conway();
+}
+
+static bool parse_int_range(const char *s, long lo, long hi, int *out) {
+  if (!s || !out) return false;
+  char *end = NULL;
+  long v = strtol(s, &end, 10);
+  if (end == s || *end != '\0') return false;
+  if (v < lo || v > hi) return false;
+  *out = (int)v;
+  return true;
+}
+
+static bool parse_kind(const char *s, EngineKind *out) {
+  if (!s || !out) return false;
+  if (strcmp(s, "byte") == 0) {
+    *out = ENGINE_BYTE;
+  } else if (strcmp(s, "packed") == 0) {
+    *out = ENGINE_PACKED;
+  } else if (strcmp(s, "tiled") == 0) {
+    *out = ENGINE_TILED;
+  } else if (strcmp(s, "active") == 0) {
+    *out = ENGINE_ACTIVE;
+  } else if (strcmp(s, "hashlife") == 0) {
+    *out = ENGINE_HASHLIFE;
+  } else if (strcmp(s, "sparse") == 0) {
+    *out = ENGINE_SPARSE;
+  } else if (strcmp(s, "chunked") == 0) {
+    *out = ENGINE_CHUNKED;
+  } else if (strcmp(s, "wavefront") == 0) {
+    *out = ENGINE_WAVEFRONT;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+int engine_parse_arg(EngineOptions *o, int argc, char **argv, int *i) {
+  if (!o || !argv || !i || *i >= argc) return 0;
+  const char *opt = argv[*i];
+  if (strcmp(opt, "--engine") == 0) {
+    if (*i + 1 >= argc) return -1;
+    if (!parse_kind(argv[++(*i)], &o->kind)) return -1;
+    return 1;
+  }
+  if (strcmp(opt, "--kernel") == 0) {
+    if (*i + 1 >= argc) return -1;
+    if (!life_parse_kernel(argv[++(*i)], &o->kernel)) return -1;
+    return 1;
+  }
+  if (strcmp(opt, "--threads") == 0) {
+    if (*i + 1 >= argc) return -1;
+    if (!parse_int_range(argv[++(*i)], 1, 1024, &o->threads)) return -1;
+    return 1;
+  }
+  if (strcmp(opt, "--boundary") == 0) {
+    if (*i + 1 >= argc) return -1;
+    if (!life_parse_boundary(argv[++(*i)], &o->boundary)) return -1;
+    return 1;
+  }
+  if (strcmp(opt, "--tile") == 0) {
+    if (*i + 1 >= argc) return -1;
+    if (!parse_int_range(argv[++(*i)], 8, 1 << 16, &o->tile)) return -1;
+    return 1;
+  }
+  if (strcmp(opt, "--tile-gens") == 0) {
+    if (*i + 1 >= argc) return -1;
+    if (!parse_int_range(argv[++(*i)], 1, 1024, &o->tile_gens)) return -1;
+    return 1;
+  }
+  if (strcmp(opt, "--pipeline-depth") == 0) {
+    if (*i + 1 >= argc) return -1;
+    if (!parse_int_range(argv[++(*i)], 1, 256, &o->pipeline_depth)) return -1;
+    return 1;
+  }
+  if (strcmp(opt, "--schedule") == 0) {
+    if (*i + 1 >= argc) return -1;
+    if (!life_pool_parse_schedule(argv[++(*i)], &o->schedule)) return -1;
+    return 1;
+  }
+  if (strcmp(opt, "--numa") == 0) {
+    o->numa = true;
+    return 1;
+  }
+  if (strcmp(opt, "--pages") == 0) {
+    if (*i + 1 >= argc) return -1;
+    if (!grid_parse_pages(argv[++(*i)], &o->pages)) return -1;
+    return 1;
+  }
+  if (strcmp(opt, "--hashlife-mem") == 0) {
+    int mib = 0;
+    if (*i + 1 >= argc) return -1;
+    if (!parse_int_range(argv[++(*i)], 16, 1 << 20, &mib)) return -1;
+    o->hashlife_mem = (size_t)mib << 20;
+    return 1;
+  }
+  if (strcmp(opt, "--rule") == 0) {
+    if (*i + 1 >= argc) return -1;
+    if (!life_parse_rule(argv[++(*i)], &o->rule)) return -1;
+    return 1;
+  }
+  if (strcmp(opt, "--cycle-window") == 0) {
+    if (*i + 1 >= argc) return -1;
+    if (!parse_int_range(argv[++(*i)], 0, 1 << 20, &o->cycle_window)) return -1;
+    return 1;
+  }
+  return 0;
+}
+
+const char *engine_usage(void) {
+  return "[--engine byte|packed|tiled|active|hashlife|sparse|chunked|wavefront] [--kernel auto|scalar|sse2|avx2|avx512|lut] "
+         "[--threads N] [--boundary dead|torus] [--tile N] [--tile-gens K] [--pipeline-depth D] "
+         "[--schedule steal|static] [--numa] [--pages default|thp|hugetlb] [--hashlife-mem MiB] [--cycle-window N] [--rule B3/S23]";
+}
+
+const char *engine_kind_name(EngineKind k) {
+  switch (k) {
+    case ENGINE_BYTE: return "byte";
+    case ENGINE_PACKED: return "packed";
+    case ENGINE_TILED: return "tiled";
+    case ENGINE_ACTIVE: return "active";
+    case ENGINE_HASHLIFE: return "hashlife";
+    case ENGINE_SPARSE: return "sparse";
+    case ENGINE_CHUNKED: return "chunked";
+    case ENGINE_WAVEFRONT: return "wavefront";
+  }
+  return "?";
+}
+
+bool engine_supports_boundary(EngineKind k, LifeBoundary b) {
+  return ((k != ENGINE_HASHLIFE && k != ENGINE_CHUNKED && k != ENGINE_WAVEFRONT) || b == LIFE_BOUNDARY_DEAD);
+}
+
+static void engine_zero(Engine *e) {
+  if (!e) return;
+  engine_options_default(&e->opt);
+  e->w = 0;
+  e->h = 0;
+  e->pa = (BitGrid){0};
+  e->pb = (BitGrid){0};
+  e->pa_cells = NULL;
+  e->convert_ns = 0;
+  e->pool = (LifePool){0};
+  e->tiled = (LifeTiled){0};
+  e->active = (LifeActive){0};
+  e->hl = (HashLife){0};
+  e->sparse = (SparseLife){0};
+  e->chunked = (ChunkedWorld){0};
+  e->wave = (LifeWavefront){0};
+  e->cycle = (CycleDetector){0};
+}
+
+/* --tile, or the engine's default tile side. */
+static int engine_tile(const EngineOptions *opt) {
+  if (opt->tile > 0) return opt->tile;
+  return (opt->kind == ENGINE_ACTIVE) ? 64 : 512;
+}
+
+bool engine_configure(const EngineOptions *opt) {
+  if (!opt) return false;
+  if (!life_set_kernel(opt->kernel)) return false;
+  if (!life_set_rule(&opt->rule)) return false;
+  return life_set_boundary(opt->boundary);
+}
+
+bool engine_init(Engine *e, const EngineOptions *opt, int w, int h) {
+  if (!e || !opt || w <= 0 || h <= 0) {
+    return false;
+  }
+  engine_zero(e);
+  if (!engine_supports_boundary(opt->kind, opt->boundary) || !engine_configure(opt)) {
+    return false;
+  }
+  e->opt = *opt;
+  e->w = w;
+  e->h = h;
+
+  if (!life_pool_init(&e->pool, opt->threads)) {
+    engine_free(e);
+    return false;
+  }
+  e->pool.schedule = opt->schedule;
+  if (opt->numa) {
+    /* Best effort: a thread that cannot be pinned still steps its band. */
+    (void)life_pool_pin(&e->pool);
+  }
+  if (opt->kind == ENGINE_PACKED) {
+    if (!bitgrid_create(&e->pa, w, h) || !bitgrid_create(&e->pb, w, h)) {
+      engine_free(e);
+      return false;
+    }
+    if (opt->numa) {
+      const size_t row_bytes = (size_t)e->pa.words * sizeof(uint64_t);
+      life_pool_place(&e->pool, e->pa.bits, row_bytes, h);
+      life_pool_place(&e->pool, e->pb.bits, row_bytes, h);
+    }
+  }
+  if (opt->kind == ENGINE_TILED) {
+    if (!life_tiled_init(&e->tiled, engine_tile(opt), opt->tile_gens, e->pool.nthreads)) {
+      engine_free(e);
+      return false;
+    }
+  }
+  if (opt->kind == ENGINE_ACTIVE) {
+    if (!life_active_init(&e->active, w, h, engine_tile(opt))) {
+      engine_free(e);
+      return false;
+    }
+  }
+  if (opt->kind == ENGINE_HASHLIFE) {
+    if (!hashlife_init(&e->hl, opt->hashlife_mem)) {
+      engine_free(e);
+      return false;
+    }
+  }
+  if (opt->kind == ENGINE_SPARSE) {
+    if (!sparse_init(&e->sparse, w, h)) {
+      engine_free(e);
+      return false;
+    }
+  }
+  if (opt->kind == ENGINE_CHUNKED) {
+    if (!chunked_init(&e->chunked)) {
+      engine_free(e);
+      return false;
+    }
+  }
+  if (opt->kind == ENGINE_WAVEFRONT) {
+    if (!life_wavefront_init(&e->wave, w, h, 1, opt->pipeline_depth)) {
+      engine_free(e);
+      return false;
+    }
+  }
+  if (opt->cycle_window > 0) {
+    /* The tiled and wavefront engines can only look between passes. */
+    uint64_t stride = ENGINE_CYCLE_STRIDE;
+    if (opt->kind == ENGINE_TILED) {
+      stride = (uint64_t)opt->tile_gens;
+    } else if (opt->kind == ENGINE_WAVEFRONT) {
+      stride = (uint64_t)opt->pipeline_depth;
+    }
+    if (!cycle_init(&e->cycle, (size_t)opt->cycle_window, stride)) {
+      engine_free(e);
+      return false;
+    }
+  }
+  return true;
+}
+
+void engine_free(Engine *e) {
+  if (!e) return;
+  life_pool_free(&e->pool);
+  life_tiled_free(&e->tiled);
+  life_active_free(&e->active);
+  hashlife_free(&e->hl);
+  sparse_free(&e->sparse);
+  chunked_free(&e->chunked);
+  life_wavefront_free(&e->wave);
+  cycle_free(&e->cycle);
+  bitgrid_free(&e->pa);
+  bitgrid_free(&e->pb);
+  engine_zero(e);
+}
+
+static void packed_rows(void *ctx, int y0, int y1) {
+  PackedJob *job = (PackedJob *)ctx;
+  bitgrid_step_rows(job->cur, job->next, y0, y1);
+}
+
+/* One packed generation pa -> pb, then swap so pa holds the result. */
+static void packed_step(Engine *e) {
+  PackedJob job = {&e->pa, &e->pb};
+  life_pool_run(&e->pool, packed_rows, &job, e->h);
+  BitGrid tmp = e->pa;
+  e->pa = e->pb;
+  e->pb = tmp;
+}
+
+static bool engine_dims_ok(const Engine *e, const Grid *g) {
+  return (e && g && g->cells && g->w == e->w && g->h == e->h);
+}
+
+bool engine_step(Engine *e, const Grid *cur, Grid *next) {
+  if (!engine_dims_ok(e, cur) || !engine_dims_ok(e, next)) {
+    return false;
+  }
+
+  switch (e->opt.kind) {
+    case ENGINE_BYTE:
+    case ENGINE_WAVEFRONT:
+      life_pool_step(&e->pool, cur, next);
+      return true;
+    case ENGINE_PACKED: {
+      /* Unless invalidated, pa still holds the previous call's next: stepping on from it needs no packing. */
+      uint64_t t0 = now_ns();
+      if ((!e->pa_cells || cur->cells != e->pa_cells) && !bitgrid_from_grid(&e->pa, cur)) return false;
+      e->pa_cells = NULL;
+      uint64_t t1 = now_ns();
+      packed_step(e);
+      e->convert_ns += t1 - t0;
+      t0 = now_ns();
+      if (!bitgrid_to_grid(&e->pa, next)) return false;
+      life_refresh_halo(next);
+      e->pa_cells = next->cells;
+      e->convert_ns += now_ns() - t0;
+      return true;
+    }
+    case ENGINE_TILED:
+      return life_tiled_pass(&e->tiled, &e->pool, cur, next, 1);
+    case ENGINE_ACTIVE:
+      return life_active_step(&e->active, &e->pool, cur, next, false);
+    case ENGINE_HASHLIFE:
+      if (!hashlife_load(&e->hl, cur) || !hashlife_advance(&e->hl, 1)) return false;
+      if (!hashlife_store(&e->hl, next)) return false;
+      life_refresh_halo(next);
+      return true;
+    case ENGINE_SPARSE:
+      if (!sparse_load(&e->sparse, cur) || !sparse_advance(&e->sparse, 1)) return false;
+      if (!sparse_store(&e->sparse, next)) return false;
+      life_refresh_halo(next);
+      return true;
+    case ENGINE_CHUNKED:
+      if (!chunked_load(&e->chunked, cur) || !chunked_advance(&e->chunked, &e->pool, 1)) return false;
+      if (!chunked_store(&e->chunked, next)) return false;
+      life_refresh_halo(next);
+      return true;
+  }
+  return false;
+}
+
+void engine_invalidate(Engine *e) {
+  if (e) {
+    e->pa_cells = NULL;
+  }
+}
+
+/* Generation gen of the run must be hashed for cycle detection. */
+static bool cycle_due(const Engine *e, uint64_t gen) {
+  return (e->opt.cycle_window > 0 && cycle_wants(&e->cycle, gen));
+}
+
+/*
+ * Records generation gen (hash h) of the run. Once a cycle is found, returns
+ * the step count that lands on a state equal to generation steps.
+ */
+static uint64_t cycle_check(Engine *e, uint64_t h, uint64_t gen, uint64_t steps) {
+  if (!cycle_observe(&e->cycle, h, gen)) {
+    return steps;
+  }
+  return gen + (steps - gen) % e->cycle.period;
+}
+
+void engine_place(Engine *e, Grid *g) {
+  if (!e || !e->opt.numa || !engine_dims_ok(e, g)) {
+    return;
+  }
+  life_pool_place(&e->pool, grid_row(g, 0) - g->pad, (size_t)g->stride, g->h);
+}
+
+/* --numa: moves g's cells to a buffer placed by engine_place (g's own pages sit where it was filled). */
+static bool engine_adopt(Engine *e, Grid *g) {
+  if (!e->opt.numa) {
+    return true;
+  }
+  Grid placed = {0};
+  if (!grid_create_padded(&placed, g->w, g->h, g->pad)) {
+    return false;
+  }
+  engine_place(e, &placed);
+  (void)grid_copy(&placed, g);
+  grid_swap(g, &placed);
+  grid_free(&placed);
+  return true;
+}
+
+bool engine_run(Engine *e, Grid *g, uint64_t steps) {
+  if (!engine_dims_ok(e, g)) {
+    return false;
+  }
+  cycle_reset(&e->cycle);
+
+  switch (e->opt.kind) {
+    case ENGINE_BYTE: {
+      Grid next = {0};
+      if (!engine_adopt(e, g)) return false;
+      life_refresh_halo(g);
+      if (!grid_create_padded(&next, g->w, g->h, g->pad)) return false;
+      engine_place(e, &next);
+      if (cycle_due(e, 0)) steps = cycle_check(e, cycle_hash_grid(g), 0, steps);
+      for (uint64_t i = 0; i < steps; i++) {
+        life_pool_step(&e->pool, g, &next);
+        grid_swap(g, &next);
+        if (cycle_due(e, i + 1)) steps = cycle_check(e, cycle_hash_grid(g), i + 1, steps);
+      }
+      grid_free(&next);
+      return true;
+    }
+    case ENGINE_PACKED: {
+      const size_t nwords = (size_t)e->pa.words * (size_t)e->h;
+      e->pa_cells = NULL;
+      if (!bitgrid_from_grid(&e->pa, g)) return false;
+      if (cycle_due(e, 0)) steps = cycle_check(e, cycle_hash_words(e->pa.bits, nwords), 0, steps);
+      for (uint64_t i = 0; i < steps; i++) {
+        packed_step(e);
+        if (cycle_due(e, i + 1)) steps = cycle_check(e, cycle_hash_words(e->pa.bits, nwords), i + 1, steps);
+      }
+      if (!bitgrid_to_grid(&e->pa, g)) return false;
+      life_refresh_halo(g);
+      e->pa_cells = g->cells;
+      return true;
+    }
+    case ENGINE_TILED: {
+      Grid next = {0};
+      bool ok = true;
+      life_refresh_halo(g);
+      if (!grid_create_padded(&next, g->w, g->h, g->pad)) return false;
+      if (cycle_due(e, 0)) steps = cycle_check(e, cycle_hash_grid(g), 0, steps);
+      for (uint64_t done = 0; ok && done < steps;) {
+        /* Passes end on multiples of --tile-gens (the cycle samples); one generation while refining. */
+        const uint64_t kmax = (uint64_t)e->opt.tile_gens;
+        uint64_t left = steps - done;
+        uint64_t want = cycle_refining(&e->cycle) ? 1u : kmax - done % kmax;
+        int k = (left < want) ? (int)left : (int)want;
+        ok = life_tiled_pass(&e->tiled, &e->pool, g, &next, k);
+        if (ok) {
+          grid_swap(g, &next);
+          done += (uint64_t)k;
+          if (cycle_due(e, done)) steps = cycle_check(e, cycle_hash_grid(g), done, steps);
+        }
+      }
+      grid_free(&next);
+      return ok;
+    }
+    case ENGINE_ACTIVE: {
+      /* Ping-pong: from the second step on, next holds the generation before g. */
+      Grid next = {0};
+      bool ok = true;
+      life_refresh_halo(g);
+      if (!grid_create_padded(&next, g->w, g->h, g->pad)) return false;
+      life_active_reset(&e->active);
+      if (cycle_due(e, 0)) steps = cycle_check(e, cycle_hash_grid(g), 0, steps);
+      for (uint64_t i = 0; ok && i < steps; i++) {
+        ok = life_active_step(&e->active, &e->pool, g, &next, i > 0);
+        if (ok) {
+          grid_swap(g, &next);
+          if (cycle_due(e, i + 1)) steps = cycle_check(e, cycle_hash_grid(g), i + 1, steps);
+        }
+      }
+      grid_free(&next);
+      return ok;
+    }
+    case ENGINE_HASHLIFE:
+      if (!hashlife_load(&e->hl, g) || !hashlife_advance(&e->hl, steps)) return false;
+      if (!hashlife_store(&e->hl, g)) return false;
+      life_refresh_halo(g);
+      return true;
+    case ENGINE_SPARSE: {
+      SparseLife *sp = &e->sparse;
+      if (!sparse_load(sp, g)) return false;
+      uint64_t done = 0;
+      if (cycle_due(e, 0)) steps = cycle_check(e, cycle_hash_set(sp->cells, sp->count), 0, steps);
+      while (done < steps && e->opt.cycle_window > 0 && e->cycle.period == 0) {
+        if (!sparse_advance(sp, 1)) return false;
+        done++;
+        if (cycle_due(e, done)) steps = cycle_check(e, cycle_hash_set(sp->cells, sp->count), done, steps);
+      }
+      if (!sparse_advance(sp, steps - done)) return false;
+      if (!sparse_store(sp, g)) return false;
+      life_refresh_halo(g);
+      return true;
+    }
+    case ENGINE_CHUNKED:
+      if (!chunked_load(&e->chunked, g) || !chunked_advance(&e->chunked, &e->pool, steps)) return false;
+      if (!chunked_store_bbox(&e->chunked, g)) return false;
+      life_refresh_halo(g);
+      return true;
+    case ENGINE_WAVEFRONT: {
+      bool ok = true;
+      life_refresh_halo(g);
+      if (cycle_due(e, 0)) steps = cycle_check(e, cycle_hash_grid(g), 0, steps);
+      for (uint64_t done = 0; ok && done < steps;) {
+        /* Same pass alignment as the tiled engine, on multiples of --pipeline-depth. */
+        const uint64_t kmax = (uint64_t)e->opt.pipeline_depth;
+        uint64_t left = steps - done;
+        uint64_t want = cycle_refining(&e->cycle) ? 1u : kmax - done % kmax;
+        int k = (left < want) ? (int)left : (int)want;
+        ok = life_wavefront_pass(&e->wave, &e->pool, g, k);
+        if (ok) {
+          done += (uint64_t)k;
+          if (cycle_due(e, done)) steps = cycle_check(e, cycle_hash_grid(g), done, steps);
+        }
+      }
+      return ok;
+    }
+  }
+  return false;
+}
+
+bool engine_observe(Engine *e, const Grid *g, uint64_t gen) {
+  if (!e || !g || e->opt.cycle_window <= 0) {
+    return false;
+  }
+  if (gen == 0) {
+    cycle_reset(&e->cycle);
+  }
+  if (!cycle_wants(&e->cycle, gen)) {
+    return false;
+  }
+  return cycle_observe(&e->cycle, cycle_hash_grid(g), gen);
+}
+
+bool engine_cycle(const Engine *e, uint64_t *period, uint64_t *start) {
+  if (!e || e->cycle.period == 0) {
+    return false;
+  }
+  if (period) *period = e->cycle.period;
+  if (start) *start = e->cycle.start;
+  return true;
+}
+
+int engine_numa_nodes(const Engine *e) {
+  if (!e) return 1;
+  int nodes = 1;
+  for (int i = 0; i < e->pool.nthreads; i++) {
+    const int node = life_pool_node(&e->pool, i);
+    if (node + 1 > nodes) nodes = node + 1;
+  }
+  return nodes;
+}
+
+double engine_node_bandwidth(const Engine *e, int node) {
+  if (!e) return 0.0;
+  size_t row_bytes = 0;
+  if (e->opt.kind == ENGINE_BYTE) {
+    row_bytes = 2u * ((size_t)e->w + 2u); /* one row read, one written (halo of 1) */
+  } else if (e->opt.kind == ENGINE_PACKED) {
+    row_bytes = 2u * (size_t)e->pa.words * sizeof(uint64_t);
+  } else {
+    return 0.0;
+  }
+  /* The node's threads run side by side: their rates add up. */
+  double bw = 0.0;
+  for (int i = 0; i < e->pool.nthreads; i++) {
+    const uint64_t ns = life_pool_busy_ns(&e->pool, i);
+    if (life_pool_node(&e->pool, i) == node && ns > 0) {
+      bw += (double)life_pool_rows_done(&e->pool, i) * (double)row_bytes * 1e9 / (double)ns;
+    }
+  }
+  return bw;
+}
+
+double engine_tiles_skipped(const Engine *e) {
+  if (!e || e->opt.kind != ENGINE_ACTIVE) return 0.0;
+  return life_active_skipped_ratio(&e->active);
+}
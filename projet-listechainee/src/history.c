@@ -1,6 +1,11 @@
 #include "history.h"
 
+#include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
+
+/* Nodes per block (fewer for the block that reaches cap + 1 nodes). */
+enum { HISTORY_BLOCK_NODES = 32 };
 
 static void history_zero(History *h) {
   if (!h) {
@@ -11,14 +16,94 @@ static void history_zero(History *h) {
   h->cur = NULL;
   h->len = 0;
   h->cap = 0;
+  h->pending = NULL;
+  h->free_nodes = NULL;
+  h->blocks = NULL;
+  h->w = 0;
+  h->h = 0;
+  h->pad = 0;
+  h->allocs = 0;
+  h->nodes = 0;
+  h->bytes = 0;
+  h->peak_bytes = 0;
+  h->skip = NULL;
+  h->skip_lo = 0;
+  h->skip_len = 0;
+  h->skip_room = 0;
 }
 
-static void node_free(HistoryNode *n) {
-  if (!n) {
-    return;
+/* Returns n (and its grid buffer) to the freelist. */
+static void node_release(History *h, HistoryNode *n) {
+  n->prev = NULL;
+  n->next = h->free_nodes;
+  h->free_nodes = n;
+}
+
+/* Adds a block of nodes to the freelist. */
+static bool history_grow(History *h) {
+  size_t count = HISTORY_BLOCK_NODES;
+  if (h->cap > 0 && h->cap + 1u - h->nodes < count) {
+    count = h->cap + 1u - h->nodes; /* cap linked + the one being reserved */
+  }
+  HistoryBlock *b = (HistoryBlock *)malloc(sizeof(HistoryBlock) + count * sizeof(HistoryNode));
+  if (!b) {
+    return false;
+  }
+  if (!grid_slab_create(&b->slab, count, h->w, h->h, h->pad)) {
+    free(b);
+    return false;
+  }
+  b->count = count;
+  b->next = h->blocks;
+  h->blocks = b;
+  for (size_t i = count; i-- > 0;) {
+    grid_slab_view(&b->slab, i, &b->nodes[i].grid);
+    node_release(h, &b->nodes[i]);
+  }
+  h->allocs += 2;
+  h->nodes += count;
+  h->bytes += sizeof(HistoryBlock) + count * sizeof(HistoryNode) + b->slab.bytes;
+  if (h->bytes > h->peak_bytes) {
+    h->peak_bytes = h->bytes;
+  }
+  return true;
+}
+
+static HistoryNode *node_take(History *h) {
+  if (!h->free_nodes && !history_grow(h)) {
+    return NULL;
+  }
+  HistoryNode *n = h->free_nodes;
+  h->free_nodes = n->next;
+  n->prev = NULL;
+  n->next = NULL;
+  return n;
+}
+
+/* Room for one more skip entry: moves the live entries down, or grows the array. */
+static bool skip_reserve(History *h) {
+  if (h->skip_len < h->skip_room) {
+    return true;
+  }
+  if (h->skip_lo > 0) {
+    h->skip_len -= h->skip_lo;
+    memmove(h->skip, h->skip + h->skip_lo, h->skip_len * sizeof(HistoryNode *));
+    h->skip_lo = 0;
+    return true;
   }
-  grid_destroy(n->grid);
-  free(n);
+  const size_t room = (h->skip_room > 0) ? h->skip_room * 2u : 16u;
+  HistoryNode **skip = (HistoryNode **)realloc(h->skip, room * sizeof(HistoryNode *));
+  if (!skip) {
+    return false;
+  }
+  h->bytes += (room - h->skip_room) * sizeof(HistoryNode *);
+  if (h->bytes > h->peak_bytes) {
+    h->peak_bytes = h->bytes;
+  }
+  h->skip = skip;
+  h->skip_room = room;
+  h->allocs++;
+  return true;
 }
 
 static void history_evict_oldest_if_needed(History *h) {
@@ -34,30 +119,87 @@ static void history_evict_oldest_if_needed(History *h) {
       h->tail = NULL;
       h->cur = NULL;
     }
-    node_free(old);
+    if (h->skip_lo < h->skip_len && h->skip[h->skip_lo] == old) {
+      h->skip_lo++;
+    }
+    node_release(h, old);
     h->len--;
   }
 }
 
+bool history_parse_mem(const char *s, size_t *out) {
+  char *end = NULL;
+  if (!s || !out) return false;
+  unsigned long long v = strtoull(s, &end, 10);
+  if (end == s || s[0] == '-') return false;
+  unsigned shift = 0;
+  switch (*end) {
+    case '\0': break;
+    case 'K': case 'k': shift = 10; end++; break;
+    case 'M': case 'm': shift = 20; end++; break;
+    case 'G': case 'g': shift = 30; end++; break;
+    case 'T': case 't': shift = 40; end++; break;
+    default: return false;
+  }
+  if (*end != '\0' || v == 0 || v > (unsigned long long)(SIZE_MAX >> shift)) return false;
+  *out = (size_t)v << shift;
+  return true;
+}
+
+/*
+ * Snapshots that fit in mem: cap + 1 nodes (with the one being reserved), in
+ * full blocks and a last smaller one.
+ */
+static bool history_plan(const Grid *g, size_t mem, size_t *cap) {
+  const size_t slot = grid_slab_slot_bytes(g->w, g->h, g->pad);
+  if (slot == 0) {
+    return false;
+  }
+  const size_t per = slot + sizeof(HistoryNode);
+  const size_t block = HISTORY_BLOCK_NODES * per + sizeof(HistoryBlock);
+  const size_t rest = mem % block;
+  size_t nodes = mem / block * HISTORY_BLOCK_NODES;
+  if (rest > sizeof(HistoryBlock)) {
+    nodes += (rest - sizeof(HistoryBlock)) / per;
+  }
+  if (nodes < 2) {
+    return false;
+  }
+  if (*cap == 0 || *cap > nodes - 1u) {
+    *cap = nodes - 1u;
+  }
+  return true;
+}
+
 bool history_init(History *h, const Grid *initial, size_t cap) {
+  return history_init_mem(h, initial, cap, 0);
+}
+
+bool history_init_mem(History *h, const Grid *initial, size_t cap, size_t mem) {
   if (!h || !initial || !initial->cells) {
     return false;
   }
   history_zero(h);
+  if (mem > 0 && !history_plan(initial, mem, &cap)) {
+    return false;
+  }
   h->cap = cap;
+  h->w = initial->w;
+  h->h = initial->h;
+  h->pad = initial->pad;
 
-  Grid *snap = grid_clone(initial);
-  if (!snap) {
+  HistoryNode *n = node_take(h);
+  if (!n) {
+    history_free(h);
     return false;
   }
-  HistoryNode *n = (HistoryNode *)malloc(sizeof(HistoryNode));
-  if (!n) {
-    grid_destroy(snap);
+  (void)grid_copy(&n->grid, initial);
+  n->gen = 0;
+  if (!skip_reserve(h)) {
+    history_free(h);
     return false;
   }
-  n->grid = snap;
-  n->prev = NULL;
-  n->next = NULL;
+  h->skip[h->skip_len++] = n;
 
   h->head = n;
   h->tail = n;
@@ -70,12 +212,14 @@ void history_free(History *h) {
   if (!h) {
     return;
   }
-  HistoryNode *it = h->head;
-  while (it) {
-    HistoryNode *next = it->next;
-    node_free(it);
-    it = next;
+  HistoryBlock *b = h->blocks;
+  while (b) {
+    HistoryBlock *next = b->next;
+    grid_slab_free(&b->slab);
+    free(b);
+    b = next;
   }
+  free(h->skip);
   history_zero(h);
 }
 
@@ -83,14 +227,14 @@ Grid *history_current(History *h) {
   if (!h || !h->cur) {
     return NULL;
   }
-  return h->cur->grid;
+  return &h->cur->grid;
 }
 
 const Grid *history_current_const(const History *h) {
   if (!h || !h->cur) {
     return NULL;
   }
-  return h->cur->grid;
+  return &h->cur->grid;
 }
 
 void history_clear_forward(History *h) {
@@ -101,38 +245,51 @@ void history_clear_forward(History *h) {
   HistoryNode *it = h->cur->next;
   h->cur->next = NULL;
   h->tail = h->cur;
+  while (h->skip_len > h->skip_lo && h->skip[h->skip_len - 1u]->gen > h->cur->gen) {
+    h->skip_len--;
+  }
 
   while (it) {
     HistoryNode *next = it->next;
-    node_free(it);
+    node_release(h, it);
     h->len--;
     it = next;
   }
 }
 
-bool history_push(History *h, const Grid *g) {
-  if (!h || !h->cur || !g || !g->cells) {
-    return false;
+Grid *history_reserve(History *h) {
+  if (!h || !h->cur) {
+    return NULL;
   }
 
   if (h->cur != h->tail) {
     history_clear_forward(h);
   }
+  if (!h->pending) {
+    h->pending = node_take(h);
+    if (!h->pending) {
+      return NULL;
+    }
+  }
+  return &h->pending->grid;
+}
 
-  Grid *snap = grid_clone(g);
-  if (!snap) {
+bool history_commit(History *h) {
+  if (!h || !h->cur || !h->pending) {
     return false;
   }
 
-  HistoryNode *n = (HistoryNode *)malloc(sizeof(HistoryNode));
-  if (!n) {
-    grid_destroy(snap);
-    return false;
+  HistoryNode *n = h->pending;
+  n->gen = h->tail->gen + 1u;
+  if (n->gen % HISTORY_SKIP == 0) {
+    if (!skip_reserve(h)) {
+      return false; /* still pending: the caller may retry */
+    }
+    h->skip[h->skip_len++] = n;
   }
-  n->grid = snap;
+  h->pending = NULL;
   n->prev = h->tail;
   n->next = NULL;
-
   h->tail->next = n;
   h->tail = n;
   h->cur = n;
@@ -148,6 +305,26 @@ bool history_push(History *h, const Grid *g) {
   return true;
 }
 
+bool history_push(History *h, const Grid *g) {
+  if (!h || !h->cur || !g || !g->cells || g->w != h->w || g->h != h->h) {
+    return false;
+  }
+
+  Grid *next = history_reserve(h);
+  if (!next || !grid_copy(next, g)) {
+    return false;
+  }
+  return history_commit(h);
+}
+
+size_t history_bytes(const History *h) {
+  return h ? h->bytes : 0;
+}
+
+size_t history_peak_bytes(const History *h) {
+  return h ? h->peak_bytes : 0;
+}
+
 bool history_can_back(const History *h) {
   return (h && h->cur && h->cur->prev);
 }
@@ -171,3 +348,35 @@ bool history_forward(History *h) {
   h->cur = h->cur->next;
   return true;
 }
+
+uint64_t history_generation(const History *h) {
+  return (h && h->cur) ? h->cur->gen : 0;
+}
+
+uint64_t history_first_generation(const History *h) {
+  return (h && h->head) ? h->head->gen : 0;
+}
+
+uint64_t history_last_generation(const History *h) {
+  return (h && h->tail) ? h->tail->gen : 0;
+}
+
+bool history_seek(History *h, uint64_t gen) {
+  if (!h || !h->cur || gen < h->head->gen || gen > h->tail->gen) {
+    return false;
+  }
+  /* Closest known node at or before gen: cur, an index entry, or the head. */
+  HistoryNode *it = h->head;
+  if (h->skip_lo < h->skip_len && gen >= h->skip[h->skip_lo]->gen) {
+    const size_t j = h->skip_lo + (size_t)((gen - h->skip[h->skip_lo]->gen) / HISTORY_SKIP);
+    it = h->skip[j];
+  }
+  if (h->cur->gen <= gen && h->cur->gen > it->gen) {
+    it = h->cur;
+  }
+  while (it->gen < gen) {
+    it = it->next;
+  }
+  h->cur = it;
+  return true;
+}
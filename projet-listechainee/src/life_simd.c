@@ -0,0 +1,314 @@
+#include "life_simd.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define LIFE_SIMD_X86 1
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+#ifdef LIFE_SIMD_X86
+
+static uint64_t read_xcr0(void) {
+  uint32_t eax = 0, edx = 0;
+  __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+  return ((uint64_t)edx << 32) | (uint64_t)eax;
+}
+
+void life_cpu_detect(LifeCpu *out) {
+  if (!out) return;
+  out->sse2 = false;
+  out->avx2 = false;
+  out->avx512bw = false;
+
+  unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+  if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+    return;
+  }
+  out->sse2 = (edx & bit_SSE2) != 0;
+
+  /* AVX state must be enabled by the OS (OSXSAVE + XCR0), not just by the CPU. */
+  bool osxsave = (ecx & bit_OSXSAVE) != 0;
+  if (!osxsave) {
+    return;
+  }
+  uint64_t xcr0 = read_xcr0();
+  bool ymm_ok = (xcr0 & 0x6u) == 0x6u;    /* XMM + YMM */
+  bool zmm_ok = (xcr0 & 0xe6u) == 0xe6u;  /* + opmask, ZMM_Hi256, Hi16_ZMM */
+
+  if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+    return;
+  }
+  out->avx2 = ymm_ok && (ebx & bit_AVX2) != 0;
+  out->avx512bw = zmm_ok && (ebx & bit_AVX512F) != 0 && (ebx & bit_AVX512BW) != 0;
+}
+
+/*
+ * Each kernel sums the 8 neighbors of V cells at once (bytes never exceed 8: no
+ * overflow). The row tail is covered by one last chunk overlapping the previous
+ * one, which is harmless since out never aliases the source rows.
+ */
+
+__attribute__((target("sse2")))
+static inline void chunk_sse2(const uint8_t *up, const uint8_t *mid, const uint8_t *down,
+                              uint8_t *out, int x) {
+  const __m128i one = _mm_set1_epi8(1);
+  const __m128i two = _mm_set1_epi8(2);
+  const __m128i three = _mm_set1_epi8(3);
+  __m128i n = _mm_add_epi8(_mm_loadu_si128((const __m128i *)(up + x - 1)),
+                           _mm_loadu_si128((const __m128i *)(up + x)));
+  n = _mm_add_epi8(n, _mm_loadu_si128((const __m128i *)(up + x + 1)));
+  n = _mm_add_epi8(n, _mm_loadu_si128((const __m128i *)(mid + x - 1)));
+  n = _mm_add_epi8(n, _mm_loadu_si128((const __m128i *)(mid + x + 1)));
+  n = _mm_add_epi8(n, _mm_loadu_si128((const __m128i *)(down + x - 1)));
+  n = _mm_add_epi8(n, _mm_loadu_si128((const __m128i *)(down + x)));
+  n = _mm_add_epi8(n, _mm_loadu_si128((const __m128i *)(down + x + 1)));
+  __m128i alive = _mm_loadu_si128((const __m128i *)(mid + x));
+
+  /* n == 3 => 1 ; n == 2 => alive */
+  __m128i born = _mm_and_si128(_mm_cmpeq_epi8(n, three), one);
+  __m128i keep = _mm_and_si128(_mm_cmpeq_epi8(n, two), alive);
+  _mm_storeu_si128((__m128i *)(out + x), _mm_or_si128(born, keep));
+}
+
+__attribute__((target("sse2")))
+int life_row_sse2(const uint8_t *up, const uint8_t *mid, const uint8_t *down, uint8_t *out, int w) {
+  if (w < 16 + 2) return 1;
+  int x = 1;
+  for (; x + 16 < w; x += 16) {
+    chunk_sse2(up, mid, down, out, x);
+  }
+  if (x < w - 1) {
+    chunk_sse2(up, mid, down, out, w - 1 - 16);
+  }
+  return w - 1;
+}
+
+__attribute__((target("avx2")))
+static inline void chunk_avx2(const uint8_t *up, const uint8_t *mid, const uint8_t *down,
+                              uint8_t *out, int x) {
+  const __m256i one = _mm256_set1_epi8(1);
+  const __m256i two = _mm256_set1_epi8(2);
+  const __m256i three = _mm256_set1_epi8(3);
+  __m256i n = _mm256_add_epi8(_mm256_loadu_si256((const __m256i *)(up + x - 1)),
+                              _mm256_loadu_si256((const __m256i *)(up + x)));
+  n = _mm256_add_epi8(n, _mm256_loadu_si256((const __m256i *)(up + x + 1)));
+  n = _mm256_add_epi8(n, _mm256_loadu_si256((const __m256i *)(mid + x - 1)));
+  n = _mm256_add_epi8(n, _mm256_loadu_si256((const __m256i *)(mid + x + 1)));
+  n = _mm256_add_epi8(n, _mm256_loadu_si256((const __m256i *)(down + x - 1)));
+  n = _mm256_add_epi8(n, _mm256_loadu_si256((const __m256i *)(down + x)));
+  n = _mm256_add_epi8(n, _mm256_loadu_si256((const __m256i *)(down + x + 1)));
+  __m256i alive = _mm256_loadu_si256((const __m256i *)(mid + x));
+
+  __m256i born = _mm256_and_si256(_mm256_cmpeq_epi8(n, three), one);
+  __m256i keep = _mm256_and_si256(_mm256_cmpeq_epi8(n, two), alive);
+  _mm256_storeu_si256((__m256i *)(out + x), _mm256_or_si256(born, keep));
+}
+
+__attribute__((target("avx2")))
+int life_row_avx2(const uint8_t *up, const uint8_t *mid, const uint8_t *down, uint8_t *out, int w) {
+  if (w < 32 + 2) return life_row_sse2(up, mid, down, out, w);
+  int x = 1;
+  for (; x + 32 < w; x += 32) {
+    chunk_avx2(up, mid, down, out, x);
+  }
+  if (x < w - 1) {
+    chunk_avx2(up, mid, down, out, w - 1 - 32);
+  }
+  return w - 1;
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static inline void chunk_avx512(const uint8_t *up, const uint8_t *mid, const uint8_t *down,
+                                uint8_t *out, int x) {
+  const __m512i one = _mm512_set1_epi8(1);
+  const __m512i two = _mm512_set1_epi8(2);
+  const __m512i three = _mm512_set1_epi8(3);
+  __m512i n = _mm512_add_epi8(_mm512_loadu_si512((const void *)(up + x - 1)),
+                              _mm512_loadu_si512((const void *)(up + x)));
+  n = _mm512_add_epi8(n, _mm512_loadu_si512((const void *)(up + x + 1)));
+  n = _mm512_add_epi8(n, _mm512_loadu_si512((const void *)(mid + x - 1)));
+  n = _mm512_add_epi8(n, _mm512_loadu_si512((const void *)(mid + x + 1)));
+  n = _mm512_add_epi8(n, _mm512_loadu_si512((const void *)(down + x - 1)));
+  n = _mm512_add_epi8(n, _mm512_loadu_si512((const void *)(down + x)));
+  n = _mm512_add_epi8(n, _mm512_loadu_si512((const void *)(down + x + 1)));
+  __m512i alive = _mm512_loadu_si512((const void *)(mid + x));
+
+  __mmask64 born = _mm512_cmpeq_epi8_mask(n, three);
+  __mmask64 keep = _mm512_cmpeq_epi8_mask(n, two) & _mm512_test_epi8_mask(alive, alive);
+  _mm512_storeu_si512((void *)(out + x), _mm512_maskz_mov_epi8(born | keep, one));
+}
+
+__attribute__((target("avx512f,avx512bw")))
+int life_row_avx512(const uint8_t *up, const uint8_t *mid, const uint8_t *down, uint8_t *out, int w) {
+  if (w < 64 + 2) return life_row_avx2(up, mid, down, out, w);
+  int x = 1;
+  for (; x + 64 < w; x += 64) {
+    chunk_avx512(up, mid, down, out, x);
+  }
+  if (x < w - 1) {
+    chunk_avx512(up, mid, down, out, w - 1 - 64);
+  }
+  return w - 1;
+}
+
+/*
+ * Rule kernels: same neighbor sums, then the next state is looked up in the
+ * birth/survive tables. AVX2 and AVX-512 use one byte shuffle per table (n <= 8
+ * indexes the low 16 entries); SSE2 has no shuffle and compares n with each
+ * count the rule uses.
+ */
+
+__attribute__((target("sse2")))
+static inline void chunk_rule_sse2(const uint8_t *up, const uint8_t *mid, const uint8_t *down,
+                                   uint8_t *out, int x, const LifeRuleLut *lut) {
+  const __m128i one = _mm_set1_epi8(1);
+  __m128i n = _mm_add_epi8(_mm_loadu_si128((const __m128i *)(up + x - 1)),
+                           _mm_loadu_si128((const __m128i *)(up + x)));
+  n = _mm_add_epi8(n, _mm_loadu_si128((const __m128i *)(up + x + 1)));
+  n = _mm_add_epi8(n, _mm_loadu_si128((const __m128i *)(mid + x - 1)));
+  n = _mm_add_epi8(n, _mm_loadu_si128((const __m128i *)(mid + x + 1)));
+  n = _mm_add_epi8(n, _mm_loadu_si128((const __m128i *)(down + x - 1)));
+  n = _mm_add_epi8(n, _mm_loadu_si128((const __m128i *)(down + x)));
+  n = _mm_add_epi8(n, _mm_loadu_si128((const __m128i *)(down + x + 1)));
+  __m128i alive = _mm_loadu_si128((const __m128i *)(mid + x));
+  __m128i dead = _mm_andnot_si128(alive, one);
+
+  __m128i r = _mm_setzero_si128();
+  for (int k = 0; k <= 8; k++) {
+    const uint8_t b = lut->birth[k];
+    const uint8_t s = lut->survive[k];
+    if (!b && !s) {
+      continue;
+    }
+    __m128i when = (b && s) ? one : (b ? dead : alive);
+    r = _mm_or_si128(r, _mm_and_si128(_mm_cmpeq_epi8(n, _mm_set1_epi8((char)k)), when));
+  }
+  _mm_storeu_si128((__m128i *)(out + x), r);
+}
+
+__attribute__((target("sse2")))
+int life_row_rule_sse2(const uint8_t *up, const uint8_t *mid, const uint8_t *down, uint8_t *out, int w,
+                       const LifeRuleLut *lut) {
+  if (w < 16 + 2) return 1;
+  int x = 1;
+  for (; x + 16 < w; x += 16) {
+    chunk_rule_sse2(up, mid, down, out, x, lut);
+  }
+  if (x < w - 1) {
+    chunk_rule_sse2(up, mid, down, out, w - 1 - 16, lut);
+  }
+  return w - 1;
+}
+
+__attribute__((target("avx2")))
+static inline void chunk_rule_avx2(const uint8_t *up, const uint8_t *mid, const uint8_t *down,
+                                   uint8_t *out, int x, __m256i birth, __m256i survive) {
+  const __m256i one = _mm256_set1_epi8(1);
+  __m256i n = _mm256_add_epi8(_mm256_loadu_si256((const __m256i *)(up + x - 1)),
+                              _mm256_loadu_si256((const __m256i *)(up + x)));
+  n = _mm256_add_epi8(n, _mm256_loadu_si256((const __m256i *)(up + x + 1)));
+  n = _mm256_add_epi8(n, _mm256_loadu_si256((const __m256i *)(mid + x - 1)));
+  n = _mm256_add_epi8(n, _mm256_loadu_si256((const __m256i *)(mid + x + 1)));
+  n = _mm256_add_epi8(n, _mm256_loadu_si256((const __m256i *)(down + x - 1)));
+  n = _mm256_add_epi8(n, _mm256_loadu_si256((const __m256i *)(down + x)));
+  n = _mm256_add_epi8(n, _mm256_loadu_si256((const __m256i *)(down + x + 1)));
+  __m256i alive = _mm256_loadu_si256((const __m256i *)(mid + x));
+
+  __m256i b = _mm256_shuffle_epi8(birth, n);
+  __m256i s = _mm256_shuffle_epi8(survive, n);
+  _mm256_storeu_si256((__m256i *)(out + x), _mm256_blendv_epi8(b, s, _mm256_cmpeq_epi8(alive, one)));
+}
+
+__attribute__((target("avx2")))
+int life_row_rule_avx2(const uint8_t *up, const uint8_t *mid, const uint8_t *down, uint8_t *out, int w,
+                       const LifeRuleLut *lut) {
+  if (w < 32 + 2) return life_row_rule_sse2(up, mid, down, out, w, lut);
+  const __m256i birth = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)lut->birth));
+  const __m256i survive = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)lut->survive));
+  int x = 1;
+  for (; x + 32 < w; x += 32) {
+    chunk_rule_avx2(up, mid, down, out, x, birth, survive);
+  }
+  if (x < w - 1) {
+    chunk_rule_avx2(up, mid, down, out, w - 1 - 32, birth, survive);
+  }
+  return w - 1;
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static inline void chunk_rule_avx512(const uint8_t *up, const uint8_t *mid, const uint8_t *down,
+                                     uint8_t *out, int x, __m512i birth, __m512i survive) {
+  __m512i n = _mm512_add_epi8(_mm512_loadu_si512((const void *)(up + x - 1)),
+                              _mm512_loadu_si512((const void *)(up + x)));
+  n = _mm512_add_epi8(n, _mm512_loadu_si512((const void *)(up + x + 1)));
+  n = _mm512_add_epi8(n, _mm512_loadu_si512((const void *)(mid + x - 1)));
+  n = _mm512_add_epi8(n, _mm512_loadu_si512((const void *)(mid + x + 1)));
+  n = _mm512_add_epi8(n, _mm512_loadu_si512((const void *)(down + x - 1)));
+  n = _mm512_add_epi8(n, _mm512_loadu_si512((const void *)(down + x)));
+  n = _mm512_add_epi8(n, _mm512_loadu_si512((const void *)(down + x + 1)));
+  __m512i alive = _mm512_loadu_si512((const void *)(mid + x));
+
+  __m512i b = _mm512_shuffle_epi8(birth, n);
+  __m512i s = _mm512_shuffle_epi8(survive, n);
+  _mm512_storeu_si512((void *)(out + x), _mm512_mask_blend_epi8(_mm512_test_epi8_mask(alive, alive), b, s));
+}
+
+__attribute__((target("avx512f,avx512bw")))
+int life_row_rule_avx512(const uint8_t *up, const uint8_t *mid, const uint8_t *down, uint8_t *out, int w,
+                         const LifeRuleLut *lut) {
+  if (w < 64 + 2) return life_row_rule_avx2(up, mid, down, out, w, lut);
+  const __m512i birth = _mm512_broadcast_i32x4(_mm_loadu_si128((const __m128i *)lut->birth));
+  const __m512i survive = _mm512_broadcast_i32x4(_mm_loadu_si128((const __m128i *)lut->survive));
+  int x = 1;
+  for (; x + 64 < w; x += 64) {
+    chunk_rule_avx512(up, mid, down, out, x, birth, survive);
+  }
+  if (x < w - 1) {
+    chunk_rule_avx512(up, mid, down, out, w - 1 - 64, birth, survive);
+  }
+  return w - 1;
+}
+
+#else /* !LIFE_SIMD_X86 */
+
+void life_cpu_detect(LifeCpu *out) {
+  if (!out) return;
+  out->sse2 = false;
+  out->avx2 = false;
+  out->avx512bw = false;
+}
+
+int life_row_sse2(const uint8_t *up, const uint8_t *mid, const uint8_t *down, uint8_t *out, int w) {
+  (void)up; (void)mid; (void)down; (void)out; (void)w;
+  return 1;
+}
+
+int life_row_avx2(const uint8_t *up, const uint8_t *mid, const uint8_t *down, uint8_t *out, int w) {
+  (void)up; (void)mid; (void)down; (void)out; (void)w;
+  return 1;
+}
+
+int life_row_avx512(const uint8_t *up, const uint8_t *mid, const uint8_t *down, uint8_t *out, int w) {
+  (void)up; (void)mid; (void)down; (void)out; (void)w;
+  return 1;
+}
+
+int life_row_rule_sse2(const uint8_t *up, const uint8_t *mid, const uint8_t *down, uint8_t *out, int w,
+                       const LifeRuleLut *lut) {
+  (void)up; (void)mid; (void)down; (void)out; (void)w; (void)lut;
+  return 1;
+}
+
+int life_row_rule_avx2(const uint8_t *up, const uint8_t *mid, const uint8_t *down, uint8_t *out, int w,
+                       const LifeRuleLut *lut) {
+  (void)up; (void)mid; (void)down; (void)out; (void)w; (void)lut;
+  return 1;
+}
+
+int life_row_rule_avx512(const uint8_t *up, const uint8_t *mid, const uint8_t *down, uint8_t *out, int w,
+                         const LifeRuleLut *lut) {
+  (void)up; (void)mid; (void)down; (void)out; (void)w; (void)lut;
+  return 1;
+}
+
+#endif /* LIFE_SIMD_X86 */
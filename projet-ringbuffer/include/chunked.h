@@ -0,0 +1,58 @@
+#ifndef CHUNKED_H
+#define CHUNKED_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "grid.h"
+#include "life_pool.h"
+
+/*
+ * Chunked world: an unbounded plane stored as CHUNK_SIDE x CHUNK_SIDE chunks
+ * indexed by chunk coordinates (hash table). A chunk is allocated when a live
+ * cell touches the border it shares with it, and released as soon as it holds
+ * no live cell, so memory follows the active area and the world never needs a
+ * full-grid copy to grow. Only the dead boundary makes sense (no torus).
+ *
+ * Each chunk holds two generations with a one-cell halo; a step refreshes the
+ * halo from the 8 neighbor chunks, then runs life_step_rect on the chunk.
+ */
+
+enum { CHUNK_SIDE = 64 };
+
+struct Chunk;
+
+typedef struct ChunkedWorld {
+  struct Chunk **table;  /* hash buckets by chunk coordinates */
+  size_t table_size;     /* power of two */
+  struct Chunk **chunks; /* every allocated chunk (iteration order) */
+  size_t count;
+  size_t cap;
+  struct Chunk *spare;   /* released chunks kept for reuse */
+  size_t nspare;
+  int gen;               /* buffer (0/1) holding the current generation */
+} ChunkedWorld;
+
+bool chunked_init(ChunkedWorld *cw);
+void chunked_free(ChunkedWorld *cw);
+
+/* Replaces the world with the live cells of g (cell (x, y) at world (x, y)). */
+bool chunked_load(ChunkedWorld *cw, const Grid *g);
+
+/* Advances by steps generations (chunks stepped in parallel on pool, NULL => serial). */
+bool chunked_advance(ChunkedWorld *cw, LifePool *pool, uint64_t steps);
+
+/* Writes the world window [0, g->w) x [0, g->h) into g (halo not refreshed). */
+bool chunked_store(const ChunkedWorld *cw, Grid *g);
+
+/*
+ * Replaces g with a grid covering the bounding box of the live cells (1x1 dead
+ * grid if the world is empty), keeping g's halo width (halo not refreshed).
+ */
+bool chunked_store_bbox(const ChunkedWorld *cw, Grid *g);
+
+/* Number of allocated chunks. */
+size_t chunked_count(const ChunkedWorld *cw);
+
+#endif /* CHUNKED_H */
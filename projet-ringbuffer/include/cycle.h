@@ -0,0 +1,63 @@
+#ifndef CYCLE_H
+#define CYCLE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "grid.h"
+
+/*
+ * Cycle detection: generations are summarized by 64-bit hashes, and the hashes
+ * sampled over the last window * stride generations are kept in a small
+ * open-addressing table. Only every stride-th generation is hashed (hashing a
+ * grid costs about as much as stepping it). When a sampled hash comes back, the
+ * run is inside a cycle (a still life is period 1): every generation is then
+ * hashed until the current state comes back, which gives the exact period, and
+ * the remaining generations can be skipped modulo it. Periods up to window are
+ * always found. Two states sharing a 64-bit hash is possible but negligible.
+ */
+typedef struct CycleDetector {
+  size_t window;       /* samples kept */
+  uint64_t stride;     /* generations between two samples */
+  uint64_t *ring_hash; /* hash of the sample of generation g at (g / stride) % window */
+  uint64_t *ring_gen;
+  uint64_t *keys;      /* table: hash -> generation + 1 (0 = free slot) */
+  uint64_t *gens;
+  size_t table_size;   /* power of two */
+  size_t inserted;     /* entries added since the table was last rebuilt */
+  uint64_t ref_hash;   /* refining: state that must come back */
+  uint64_t ref_gen;
+  uint64_t ref_span;   /* refining: distance of the sampled repeat (0 = sampling) */
+  uint64_t period;     /* 0 until a cycle is found */
+  uint64_t start;      /* a generation inside the cycle (where it was measured) */
+} CycleDetector;
+
+bool cycle_init(CycleDetector *c, size_t window, uint64_t stride);
+void cycle_free(CycleDetector *c);
+
+/* Forgets every generation and the detected cycle. */
+void cycle_reset(CycleDetector *c);
+
+/* True if generation gen must be hashed and passed to cycle_observe. */
+bool cycle_wants(const CycleDetector *c, uint64_t gen);
+
+/* True while the exact period is being measured (every generation wanted). */
+bool cycle_refining(const CycleDetector *c);
+
+/*
+ * Records the hash of generation gen (increasing, as asked by cycle_wants).
+ * Returns true once the period is known: period and start are set.
+ */
+bool cycle_observe(CycleDetector *c, uint64_t hash, uint64_t gen);
+
+/* Hash of the cells of g (halo and layout ignored). */
+uint64_t cycle_hash_grid(const Grid *g);
+
+/* Hash of n words, in order. */
+uint64_t cycle_hash_words(const uint64_t *words, size_t n);
+
+/* Hash of a set of n keys, independent of their order. */
+uint64_t cycle_hash_set(const uint64_t *keys, size_t n);
+
+#endif /* CYCLE_H */
@@ -0,0 +1,32 @@
+#ifndef DELTA_H
+#define DELTA_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "grid.h"
+
+/*
+ * Generation deltas: the XOR of two bit-packed grids (bitgrid.h layout), run
+ * length coded as a sequence of
+ *   varint zero words skipped, varint literal count n, n literal words
+ * (words in host byte order). Applying a delta to either grid gives the other,
+ * so one delta walks the history both ways. Still and sparse patterns change a
+ * few words per generation: the delta is then a few bytes.
+ */
+
+/* Largest encoding of nwords words (size of the encoder's output buffer). */
+size_t delta_bound(size_t nwords);
+
+/* Writes the delta between a and b (nwords words each) to out, returns its size. */
+size_t delta_encode(const uint64_t *a, const uint64_t *b, size_t nwords, uint8_t *out);
+
+/*
+ * XORs the delta d (size bytes) into bits (nwords words) and, if g is not NULL,
+ * flips the matching cells of g (same dimensions, words words per row). Returns
+ * false if d is malformed.
+ */
+bool delta_apply(const uint8_t *d, size_t size, uint64_t *bits, size_t nwords, Grid *g, int words);
+
+#endif /* DELTA_H */
@@ -0,0 +1,80 @@
+#ifndef HASHLIFE_H
+#define HASHLIFE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "grid.h"
+
+/*
+ * HashLife: the universe is a quadtree whose nodes are hash-consed (two equal
+ * subtrees are one node), and every node memoizes its successor: the center
+ * half of the node advanced by 2^j generations. Regular patterns therefore
+ * advance by huge jumps (10^12 generations and beyond) in little time.
+ *
+ * The plane is unbounded: cells that leave the loaded grid keep evolving, and
+ * hashlife_store writes back the window covered by the grid. Only the dead
+ * boundary makes sense here (no torus). The base case applies life_rule(),
+ * which must not change while a HashLife holds memoized successors.
+ *
+ * Memory: nodes live in slabs recycled through a free list. Once the node
+ * store exceeds mem_cap between two jumps, unreachable nodes are collected
+ * (mark & sweep from the root); if the live tree alone stays above half the
+ * cap, later jumps are made smaller. The cap is soft: a single jump may
+ * overshoot it.
+ */
+
+struct HLNode;
+struct HLSlab;
+
+/* Why hashlife_advance stopped. */
+typedef enum HashLifeError {
+  HASHLIFE_OK = 0,
+  HASHLIFE_NO_MEMORY, /* a node could not be allocated */
+  HASHLIFE_TOO_FAR    /* live cells would leave the 2^62 x 2^62 plane the coordinates can hold */
+} HashLifeError;
+
+typedef struct HashLife {
+  struct HLNode *root;
+  int level;             /* root covers 2^level x 2^level cells */
+  int64_t ox;            /* world coordinates of the root's top-left cell */
+  int64_t oy;
+  uint64_t generation;   /* generations advanced since hashlife_load */
+  int max_jump;          /* log2 of the largest jump (lowered under memory pressure) */
+
+  struct HLNode **table; /* hash buckets (chained through HLNode.next) */
+  size_t table_size;     /* power of two */
+  size_t nodes;          /* live (hashed) nodes */
+  struct HLNode *free_list;
+  struct HLSlab *slabs;
+  struct HLNode *empty[64]; /* canonical empty node of each level (lazily built) */
+
+  size_t mem_cap;        /* bytes */
+  uint64_t gc_runs;
+  HashLifeError error;   /* set by hashlife_advance */
+} HashLife;
+
+/* mem_cap in bytes (0 => default). */
+bool hashlife_init(HashLife *hl, size_t mem_cap);
+void hashlife_free(HashLife *hl);
+
+/* Replaces the universe with the live cells of g (cell (x, y) at world (x, y)). */
+bool hashlife_load(HashLife *hl, const Grid *g);
+
+/*
+ * Advances the universe by steps generations. Returns false, with hl->error
+ * telling why, if a node could not be allocated (HASHLIFE_NO_MEMORY) or if the
+ * root would have to grow past level 62, i.e. the pattern spreads beyond the
+ * representable plane: this happens for very large step counts
+ * (HASHLIFE_TOO_FAR). The universe is then left at hl->generation.
+ */
+bool hashlife_advance(HashLife *hl, uint64_t steps);
+
+/* Writes the world window [0, g->w) x [0, g->h) into g (halo not refreshed). */
+bool hashlife_store(const HashLife *hl, Grid *g);
+
+/* Bytes used by the node store (nodes + hash table). */
+size_t hashlife_mem_bytes(const HashLife *hl);
+
+#endif /* HASHLIFE_H */
@@ -3,36 +3,213 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 
+#include "bitgrid.h"
 #include "grid.h"
+#include "history_log.h"
+
+/*
+ * Storage of the snapshots:
+ * - HISTORY_FULL: one full grid per generation
+ * - HISTORY_DELTA: the XOR with the previous generation, run-length coded
+ *   (delta.h), plus a bit-packed keyframe every `keyframe` generations (and
+ *   for the oldest one). Only the current generation exists as a grid: moving
+ *   applies the deltas in between, starting from the current grid or from the
+ *   nearest keyframe, whichever is closer.
+ * - HISTORY_CHECKPOINT: one full grid every `keyframe` generations (the
+ *   checkpoints); the generations in between are recomputed with life_step
+ *   from the checkpoint before them when moving onto them, into a cache of
+ *   keyframe - 1 grids that holds the span of one checkpoint. Unless given,
+ *   keyframe is the smallest one whose grids fit in the memory budget; if
+ *   none does, the capacity shrinks. The history then holds at least cap
+ *   generations, and drops the oldest checkpoint's span at once.
+ * - HISTORY_DISK: the whole timeline, appended to an on-disk log
+ *   (history_log.h) by a writer thread; the last cap generations stay in a RAM
+ *   ring of full grids, older ones are read back from the log's mapping when
+ *   moving onto them. Nothing is ever evicted (first_gen stays 0).
+ */
+typedef enum HistoryMode {
+  HISTORY_FULL = 0,
+  HISTORY_DELTA,
+  HISTORY_CHECKPOINT,
+  HISTORY_DISK
+} HistoryMode;
+
+typedef struct HistoryOptions {
+  HistoryMode mode;
+  int keyframe; /* generations between two keyframes/checkpoints (0 => delta: 64, checkpoint: from mem) */
+  size_t mem;   /* memory budget in bytes, sets the capacity (0 => none; checkpoint mode: 1 GiB) */
+  const char *path; /* disk mode: log file (NULL => "history.log") */
+  bool compress;    /* disk mode: run-length coded records */
+} HistoryOptions;
+
+/* Delta mode: generation (first_gen + rel) relative to the previous one. */
+typedef struct HistoryDelta {
+  uint8_t *data;
+  size_t size;
+  size_t room; /* allocated bytes (buffers are reused when the ring wraps) */
+  int key;     /* keyframe index, -1 if none */
+} HistoryDelta;
 
 /*
  * Ring-buffer history (bounded timeline).
+ * - slab: cap + 1 snapshot buffers of the initial grid's layout (full mode) or
+ *   2 (delta mode: current and reserved), allocated once by history_init; the
+ *   extra one is always free, so the next snapshot can be written while the
+ *   current one is still read
+ * - slots: slots[i] views buffer i of the slab
  * - cap: maximum capacity in snapshots
- * - start: physical index of the oldest snapshot
+ * - start: physical index of the oldest snapshot (in 0..cap)
  * - len: number of stored snapshots (0..cap)
  * - cur: current relative position (0..len-1)
+ * - first_gen: generation number of the oldest snapshot (the initial grid is 0)
+ * - reserved: history_reserve handed out the slot after the last snapshot
+ * - allocs: heap allocations made so far
+ * Delta mode only:
+ * - deltas: cap entries (ring indexed like the snapshots); the entry of the
+ *   oldest snapshot always holds a keyframe
+ * - view: slots[view] holds generation cur, packed in bits[0]
+ * - keys: nkeys keyframes of bits[0].words * h words; free_keys lists the unused ones
+ * - enc: encoder output (delta_bound bytes)
+ * Checkpoint mode only (first_gen is a multiple of keyframe):
+ * - slots[0 .. nck): ring of checkpoints, start being the oldest one's
+ * - slots[nck + g % keyframe - 1]: generation g between two checkpoints,
+ *   valid for the generations cache_seg * keyframe + 1 .. cache_hi (if cached)
+ * - recomputed: generations recomputed so far
+ * Disk mode only:
+ * - slots[0 .. cap]: RAM ring, generation g in slots[g % (cap + 1)] while
+ *   g >= ring_lo and g >= len - cap; slots[cap + 1] holds generation view_gen,
+ *   read from the log
+ * - log: every generation, record g being generation g
+ * Byte budget:
+ * - mem: opt->mem (0 if none); delta mode evicts to stay under it
+ * - delta_bytes: bytes allocated for the deltas
+ * - peak_bytes: highest history_bytes so far
  */
 typedef struct History {
-  Grid **buf;
+  HistoryMode mode;
+  GridSlab slab;
+  Grid *slots;
   size_t cap;
   size_t start;
   size_t len;
   size_t cur;
+  uint64_t first_gen;
+  bool reserved;
+  size_t allocs;
+
+  int keyframe;
+  HistoryDelta *deltas;
+  int view;
+  BitGrid bits[2];
+  size_t nwords;
+  uint64_t *keys;
+  int *free_keys;
+  int nfree;
+  int nkeys;
+  uint8_t *enc;
+
+  size_t nck;
+  bool cached;
+  uint64_t cache_seg;
+  uint64_t cache_hi;
+  size_t recomputed;
+
+  HistoryLog *log;
+  size_t ring_lo;
+  size_t view_gen;
+
+  size_t mem;
+  size_t delta_bytes;
+  size_t peak_bytes;
 } History;
 
+/* Full mode, keyframe and budget by default. */
+void history_options_default(HistoryOptions *o);
+
+/*
+ * Parses argv[*i] if it is a history option (--history-mode full|delta|checkpoint|disk,
+ * --history-keyframe K, --history-mem SIZE[K|M|G], --history-file PATH, --history-compress). Same return convention as engine_parse_arg.
+ */
+int history_parse_arg(HistoryOptions *o, int argc, char **argv, int *i);
+
+/* "512M", "2G", "65536": bytes, binary suffixes K, M, G, T (non-zero). */
+bool history_parse_mem(const char *s, size_t *out);
+
+/* Usage fragment for the history options. */
+const char *history_usage(void);
+const char *history_mode_name(HistoryMode m);
+
+/* Full mode history of cap snapshots (0 => 512). */
 bool history_init(History *h, const Grid *initial, size_t cap);
+
+/*
+ * Same, storage chosen by opt (NULL => full mode). With opt->mem, the capacity
+ * is what fits in the budget for this grid size and storage, at most cap
+ * (0 => no other limit); false if not even one snapshot fits. h->cap and
+ * h->keyframe hold the capacity and interval actually used. Delta mode also
+ * evicts at run time to stay under opt->mem, as its deltas grow.
+ */
+bool history_init_with(History *h, const Grid *initial, size_t cap, const HistoryOptions *opt);
 void history_free(History *h);
 
 Grid *history_current(History *h);
 const Grid *history_current_const(const History *h);
 
 void history_clear_forward(History *h);
+
+/*
+ * Copies g (same w and h as the initial grid) into the next slot. Checkpoint
+ * mode only stores checkpoints, so between two of them g must be the
+ * life_step of the current grid (any edit would be lost when the span is
+ * recomputed): otherwise the push is rejected (false) and only the states
+ * after cur are dropped. A g landing on a checkpoint is stored as is.
+ */
 bool history_push(History *h, const Grid *g);
 
+/*
+ * Zero-copy push, for stepping straight into the history:
+ *   Grid *next = history_reserve(h);
+ *   life_step(history_current(h), next);
+ *   history_commit(h);
+ * history_reserve drops the states after cur and returns the buffer of the
+ * next snapshot (same layout as the current one, contents undefined), never
+ * the current one. history_commit makes it current, evicting the oldest
+ * snapshot when cap are stored. Full mode copies and allocates nothing; delta
+ * mode packs the new grid and stores its delta. Checkpoint mode copies nothing
+ * either; reserving a checkpoint may drop the oldest span.
+ */
+Grid *history_reserve(History *h);
+bool history_commit(History *h);
+
+/* RAM held by the history (buffers, keyframes, deltas, work buffers, log queue). */
+size_t history_bytes(const History *h);
+
+/* Highest history_bytes since history_init. */
+size_t history_peak_bytes(const History *h);
+
+/* Disk mode: bytes of the log file written so far (0 otherwise). */
+uint64_t history_disk_bytes(const History *h);
+
 bool history_can_back(const History *h);
 bool history_can_forward(const History *h);
 bool history_back(History *h);
 bool history_forward(History *h);
 
+/*
+ * Absolute generation numbers (the initial grid is 0): the current one, and
+ * the oldest and newest still stored. They keep counting across evictions.
+ */
+uint64_t history_generation(const History *h);
+uint64_t history_first_generation(const History *h);
+uint64_t history_last_generation(const History *h);
+
+/*
+ * Makes generation gen current, if it is stored (first..last); false
+ * otherwise. Costs one index (full, disk in RAM), at most keyframe - 1 deltas
+ * or recomputed generations (delta, checkpoint), or one log read (disk).
+ */
+bool history_seek(History *h, uint64_t gen);
+
 #endif /* HISTORY_H */
@@ -0,0 +1,73 @@
+#ifndef HISTORY_LOG_H
+#define HISTORY_LOG_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "bitgrid.h"
+#include "grid.h"
+
+/*
+ * On-disk log of generations, for timelines longer than RAM (the history's
+ * disk mode). PATH holds a 64-byte header
+ *   "GOLHLOG1", uint32 w, uint32 h, uint32 flags, uint32 words per row
+ * then one record per generation: the grid bit-packed (bitgrid.h layout), or
+ * with HISTORY_LOG_COMPRESS its delta against an empty grid (delta.h: runs of
+ * empty words are skipped). PATH.idx holds the end offset of each record
+ * (uint64, host byte order), so record i spans [end[i-1], end[i]) with
+ * end[-1] = 64. The index is read back from PATH.idx rather than kept in RAM,
+ * so the log's memory does not grow with the timeline. Both files stay on disk
+ * for post-mortem reading.
+ *
+ * Records are written by a thread of the log: history_log_append queues a
+ * grid, which must stay unchanged until history_log_wait says it is written.
+ * Reads go through a read-only mapping of PATH, so old generations are paged
+ * in on demand.
+ */
+
+enum { HISTORY_LOG_COMPRESS = 1 };
+
+/* Writer thread, queue and mapping (defined in history_log.c). */
+struct HistoryLogSync;
+
+typedef struct HistoryLog {
+  int fd;
+  int idx_fd;
+  int w;
+  int h;
+  unsigned flags;
+  size_t nwords;    /* words of a packed grid */
+  size_t qcap;      /* grids queued at most */
+  struct HistoryLogSync *sync;
+  BitGrid read_bits; /* history_log_read's unpacking buffer */
+} HistoryLog;
+
+/*
+ * Creates PATH and PATH.idx for w*h grids (replacing them) and starts the
+ * writer. At most qcap grids wait in the queue. Another log may still be open
+ * on the same PATH: it goes on with its own, unlinked, files. On failure,
+ * PATH and PATH.idx are left as they were.
+ */
+bool history_log_open(HistoryLog *log, const char *path, int w, int h, unsigned flags, size_t qcap);
+
+/* Writes the queued records and the index, stops the writer, closes the files. */
+void history_log_close(HistoryLog *log);
+
+/* Queues g as the next record (waits if qcap grids are queued). */
+bool history_log_append(HistoryLog *log, const Grid *g);
+
+/* Waits until the first count records are written. False after a write error. */
+bool history_log_wait(HistoryLog *log, uint64_t count);
+
+/* Waits for the queue, then keeps only the first count records. */
+bool history_log_truncate(HistoryLog *log, uint64_t count);
+
+/* Unpacks record i (written: see history_log_wait) into g (w*h). */
+bool history_log_read(HistoryLog *log, uint64_t i, Grid *g);
+
+/* Records queued so far (written or not), and bytes of PATH written. */
+uint64_t history_log_count(const HistoryLog *log);
+uint64_t history_log_bytes(const HistoryLog *log);
+
+#endif /* HISTORY_LOG_H */
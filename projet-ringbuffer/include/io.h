@@ -5,14 +5,19 @@
 #include <stddef.h>
 
 #include "grid.h"
+#include "life.h"
 
 /*
  * Format:
- *   width height
+ *   width height [rule]
  *   then height lines, each with width chars in {'.','O'}
  *   trailing spaces/tabs are allowed.
+ * The optional rule ("B3/S23") is written by grid_save_to_file (active rule).
  */
 bool grid_load_from_file(const char *path, Grid *out, char *err, size_t errcap);
 bool grid_save_to_file(const char *path, const Grid *g, char *err, size_t errcap);
 
+/* Same as grid_load_from_file; *rule receives the header rule if there is one (else untouched). */
+bool grid_load_with_rule(const char *path, Grid *out, LifeRule *rule, char *err, size_t errcap);
+
 #endif /* IO_H */
@@ -1,11 +1,99 @@
 #ifndef LIFE_H
 #define LIFE_H
 
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
 #include "grid.h"
 
+/*
+ * Byte kernels for life_step. AUTO picks the widest one supported by the CPU
+ * (detected once with cpuid); the vector kernels fall back to scalar code for
+ * the border cells. LUT steps 2x2 blocks with one lookup of their 4x4
+ * neighborhood in a 64K-entry table (grids with a halo only; never picked by
+ * AUTO).
+ */
+typedef enum LifeKernel {
+  LIFE_KERNEL_AUTO = 0,
+  LIFE_KERNEL_SCALAR,
+  LIFE_KERNEL_SSE2,
+  LIFE_KERNEL_AVX2,
+  LIFE_KERNEL_AVX512,
+  LIFE_KERNEL_LUT
+} LifeKernel;
+
+/*
+ * Boundary rule. DEAD: out-of-bounds cells are dead. TORUS: edges wrap around.
+ * On grids with a halo (pad >= 1) the torus costs no per-cell work: life_step
+ * refreshes the halo of next by copying the wrapped edges once per generation.
+ */
+typedef enum LifeBoundary {
+  LIFE_BOUNDARY_DEAD = 0,
+  LIFE_BOUNDARY_TORUS
+} LifeBoundary;
+
+/*
+ * Outer-totalistic rule "Bx/Sy": a dead cell with n living neighbors is born if
+ * birth[n], a living one survives if survive[n] (entries are 0 or 1). Parsed
+ * once; B3/S23 runs on specialized kernels, any other rule on table-driven ones.
+ */
+typedef struct LifeRule {
+  uint8_t birth[9];
+  uint8_t survive[9];
+} LifeRule;
+
 /* Counts the 8 living neighbors (out-of-bounds => dead). */
 int count_neighbors(const Grid *g, int x, int y);
 
+/*
+ * Selects the kernel used by life_step (AUTO => best supported).
+ * Returns false if the CPU does not support it (selection unchanged).
+ * Call before starting threads that step grids.
+ */
+bool life_set_kernel(LifeKernel k);
+
+/* Kernel actually used by life_step (never AUTO). */
+LifeKernel life_active_kernel(void);
+
+const char *life_kernel_name(LifeKernel k);
+
+/* Parses "auto", "scalar", "sse2", "avx2", "avx512" or "lut". */
+bool life_parse_kernel(const char *s, LifeKernel *out);
+
+/* Selects the boundary used by life_step (call before starting threads). */
+bool life_set_boundary(LifeBoundary b);
+LifeBoundary life_boundary(void);
+const char *life_boundary_name(LifeBoundary b);
+
+/* Parses "dead" or "torus". */
+bool life_parse_boundary(const char *s, LifeBoundary *out);
+
+/* B3/S23. */
+LifeRule life_rule_conway(void);
+bool life_rule_is_conway(const LifeRule *r);
+
+/* Selects the rule used by every engine (call before starting threads). */
+bool life_set_rule(const LifeRule *r);
+const LifeRule *life_rule(void);
+
+/*
+ * Parses "B36/S23" (case-insensitive, either part first, digits 0-8).
+ * Rules with B0 are rejected: empty space must stay empty (dead halo,
+ * unbounded engines).
+ */
+bool life_parse_rule(const char *s, LifeRule *out);
+
+/* Canonical "B36/S23" form of r (cap >= 24 is always enough). */
+void life_rule_format(const LifeRule *r, char *buf, size_t cap);
+
+/*
+ * Makes the halo of g match the active boundary (wrapped edges or dead cells).
+ * Needed once for a grid filled outside life_step (loaded, edited, resized);
+ * grids produced by life_step keep it up to date.
+ */
+void life_refresh_halo(Grid *g);
+
 /*
  * Computes the next generation from cur into next.
  * next must be allocated with the same dimensions as cur.
@@ -13,4 +101,13 @@ int count_neighbors(const Grid *g, int x, int y);
  */
 void life_step(const Grid *cur, Grid *next);
 
+/*
+ * Same as life_step, restricted to rows [y0, y1).
+ * Does not refresh the halo of next: call life_refresh_halo once every band is done.
+ */
+void life_step_rows(const Grid *cur, Grid *next, int y0, int y1);
+
+/* Same as life_step_rows, restricted to the cells [x0, x1) x [y0, y1). */
+void life_step_rect(const Grid *cur, Grid *next, int x0, int y0, int x1, int y1);
+
 #endif /* LIFE_H */
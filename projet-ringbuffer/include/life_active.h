@@ -0,0 +1,46 @@
+#ifndef LIFE_ACTIVE_H
+#define LIFE_ACTIVE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "grid.h"
+#include "life_pool.h"
+
+/*
+ * Active-tile tracking: the grid is cut into tile x tile blocks and a block is
+ * recomputed only if it or one of its 8 neighbors changed during the previous
+ * generation (a cell only sees its 8 neighbors, so any other block is still).
+ * Still and empty regions cost a copy, or nothing when next already holds them.
+ * Each step assumes cur is the result of the previous step (a timeline); call
+ * life_active_reset before stepping an unrelated grid.
+ */
+typedef struct LifeActive {
+  int tile;
+  int tiles_x;
+  int tiles_y;
+  uint8_t *changed; /* per tile: changed during the previous generation */
+  uint8_t *next_changed;
+  uint8_t *active;  /* per tile: recomputed during the current generation */
+  uint64_t tiles_stepped; /* counters since init */
+  uint64_t tiles_skipped;
+} LifeActive;
+
+bool life_active_init(LifeActive *a, int w, int h, int tile);
+void life_active_free(LifeActive *a);
+
+/* Forgets the change history: the next step recomputes every tile. */
+void life_active_reset(LifeActive *a);
+
+/*
+ * Computes one generation from cur into next, recomputing only the active tiles
+ * (spans of tiles scheduled as tasks on pool, NULL => calling thread). If
+ * next_is_prev, next holds the generation before cur and skipped tiles are left
+ * untouched; otherwise they are copied from cur. next gets an up-to-date halo.
+ */
+bool life_active_step(LifeActive *a, LifePool *pool, const Grid *cur, Grid *next, bool next_is_prev);
+
+/* Fraction of the tiles skipped since init (0 before the first step). */
+double life_active_skipped_ratio(const LifeActive *a);
+
+#endif /* LIFE_ACTIVE_H */
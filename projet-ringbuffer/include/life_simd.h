@@ -0,0 +1,40 @@
+#ifndef LIFE_SIMD_H
+#define LIFE_SIMD_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* CPU features relevant to the byte kernels (detected with cpuid + xgetbv). */
+typedef struct LifeCpu {
+  bool sse2;
+  bool avx2;
+  bool avx512bw;
+} LifeCpu;
+
+void life_cpu_detect(LifeCpu *out);
+
+/*
+ * Vectorized interior of one row: computes out[x] for x in [1, k) from the three
+ * source rows up/mid/down (each w cells, values in {0,1}) and returns k.
+ * k is the first column left to the caller (k <= w - 1, or 1 if the row is too
+ * short for a single vector). Only available on x86; callers check LifeCpu first.
+ */
+int life_row_sse2(const uint8_t *up, const uint8_t *mid, const uint8_t *down, uint8_t *out, int w);
+int life_row_avx2(const uint8_t *up, const uint8_t *mid, const uint8_t *down, uint8_t *out, int w);
+int life_row_avx512(const uint8_t *up, const uint8_t *mid, const uint8_t *down, uint8_t *out, int w);
+
+/* Rule tables padded to 16 entries (one pshufb lookup each). */
+typedef struct LifeRuleLut {
+  uint8_t birth[16];
+  uint8_t survive[16];
+} LifeRuleLut;
+
+/* Same as the kernels above for any rule: out[x] = (alive ? survive : birth)[n]. */
+int life_row_rule_sse2(const uint8_t *up, const uint8_t *mid, const uint8_t *down, uint8_t *out, int w,
+                       const LifeRuleLut *lut);
+int life_row_rule_avx2(const uint8_t *up, const uint8_t *mid, const uint8_t *down, uint8_t *out, int w,
+                       const LifeRuleLut *lut);
+int life_row_rule_avx512(const uint8_t *up, const uint8_t *mid, const uint8_t *down, uint8_t *out, int w,
+                         const LifeRuleLut *lut);
+
+#endif /* LIFE_SIMD_H */
@@ -0,0 +1,36 @@
+#ifndef LIFE_TILED_H
+#define LIFE_TILED_H
+
+#include <stdbool.h>
+
+#include "grid.h"
+#include "life_pool.h"
+
+/*
+ * Temporal blocking: each tile x tile block is copied with a ghost zone of k
+ * cells into a small local buffer, advanced k generations there, and its center
+ * written to next. Ghost cells go stale by one cell per generation, so after k
+ * generations the center is exact. The grid streams through memory once per k
+ * generations instead of once per generation, at the price of recomputing the
+ * ghost zones ((tile+2k)^2 cells of work per tile*tile cells of output).
+ */
+
+typedef struct LifeTiled {
+  int tile;     /* tile side in cells */
+  int max_gens; /* generations per pass at most (ghost zone width) */
+  int nbands;   /* one pair of local buffers per pool thread */
+  Grid *bufs;   /* 2 * nbands grids of (tile + 2 * max_gens)^2 cells */
+} LifeTiled;
+
+/* Allocates the local buffers once, for a pool of nthreads (<= 1 => one pair). */
+bool life_tiled_init(LifeTiled *t, int tile, int max_gens, int nthreads);
+void life_tiled_free(LifeTiled *t);
+
+/*
+ * Advances cur by k (1..max_gens) generations into next (same dimensions),
+ * honoring the active boundary. Tiles are scheduled as tasks on pool (NULL =>
+ * calling thread). next gets an up-to-date halo.
+ */
+bool life_tiled_pass(LifeTiled *t, LifePool *pool, const Grid *cur, Grid *next, int k);
+
+#endif /* LIFE_TILED_H */
@@ -0,0 +1,43 @@
+#ifndef LIFE_WAVEFRONT_H
+#define LIFE_WAVEFRONT_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+
+#include "grid.h"
+#include "life_pool.h"
+
+/*
+ * Wavefront pipeline: a pass advances the grid by k generations with k stages
+ * in flight at once. Stage s computes generation t+s+1 from the rows stage s-1
+ * has already written, trailing it by a few rows; each stage publishes the
+ * number of rows it has finished in a progress counter, so stages wait on their
+ * predecessor only, and the pool synchronizes once per pass instead of once per
+ * generation. Consecutive stages touch the same rows while they are still in
+ * cache. Stages are split into contiguous groups, one per pool thread; a thread
+ * interleaves its own stages row block by row block.
+ *
+ * Row 0 of a torus depends on the last row of the previous generation, which
+ * would serialize the stages: only the dead boundary is supported.
+ */
+
+typedef struct LifeWavefront {
+  int w;
+  int h;
+  int depth;         /* stages (generations) per pass at most */
+  Grid *bufs;        /* depth grids: outputs of the stages */
+  atomic_int *done;  /* rows finished by each stage in the current pass */
+} LifeWavefront;
+
+/* Allocates the stage buffers once for w*h grids with a halo of pad cells. */
+bool life_wavefront_init(LifeWavefront *wf, int w, int h, int pad, int depth);
+void life_wavefront_free(LifeWavefront *wf);
+
+/*
+ * Advances g (dead halo, same dimensions) in place by k (1..depth) generations,
+ * stage groups running on pool (NULL => calling thread). Bit-identical to k
+ * calls of life_step.
+ */
+bool life_wavefront_pass(LifeWavefront *wf, LifePool *pool, Grid *g, int k);
+
+#endif /* LIFE_WAVEFRONT_H */
@@ -0,0 +1,44 @@
+#ifndef SPARSE_H
+#define SPARSE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "grid.h"
+
+/*
+ * Sparse engine: only the live cells of a w*h world are kept, as a list of
+ * packed (x, y) coordinates. A generation scatters every live cell into an
+ * open-addressing table of neighbor counts, then keeps the entries the rule
+ * makes alive. Time and memory scale with the population, not
+ * with the area, which suits a few live cells spread over a huge grid.
+ * The boundary and the cell rule are read from life_boundary() (dead or torus)
+ * and life_rule().
+ */
+typedef struct SparseLife {
+  int w;
+  int h;
+  uint64_t *cells;    /* live cells: (uint64_t)y << 32 | x, unordered */
+  size_t count;
+  size_t cap;
+  uint64_t *scratch;  /* next generation, swapped with cells */
+  size_t scratch_cap;
+  uint64_t *keys;     /* count table (SPARSE_EMPTY = free slot) */
+  uint8_t *counts;    /* neighbor count in bits 0-3, bit 4 = alive */
+  size_t table_size;  /* power of two */
+} SparseLife;
+
+bool sparse_init(SparseLife *s, int w, int h);
+void sparse_free(SparseLife *s);
+
+/* Replaces the live cells with those of g (same dimensions). */
+bool sparse_load(SparseLife *s, const Grid *g);
+
+/* Advances by steps generations. Returns false if out of memory. */
+bool sparse_advance(SparseLife *s, uint64_t steps);
+
+/* Writes the live cells into g (halo not refreshed). */
+bool sparse_store(const SparseLife *s, Grid *g);
+
+#endif /* SPARSE_H */
@@ -16,7 +16,9 @@ typedef enum UiAction {
   UI_ACT_BACK,
   UI_ACT_FORWARD,
   UI_ACT_SAVE,
-  UI_ACT_RESIZE
+  UI_ACT_RESIZE,
+  UI_ACT_GOTO, /* G: go to a generation typed in the terminal */
+  UI_ACT_SEEK  /* click or drag on the timeline: go to ui->seek_gen */
 } UiAction;
 
 typedef struct UiSdl {
@@ -24,15 +26,28 @@ typedef struct UiSdl {
   SDL_Renderer *ren;
   int win_w;
   int win_h;
+  char title[96]; /* window title given to ui_init */
+  /* Timeline (bottom bar, shown when tl_last > tl_first). */
+  uint64_t tl_first;
+  uint64_t tl_cur;
+  uint64_t tl_last;
+  bool tl_drag;      /* left button held since a click on the bar */
+  uint64_t seek_gen; /* target of the last UI_ACT_SEEK */
 } UiSdl;
 
 bool ui_init(UiSdl *ui, const char *title, int win_w, int win_h);
 void ui_shutdown(UiSdl *ui);
 
-/* Renders the grid with colors (alive/dead). */
+/* Shows status after the title, in the title bar (NULL or "" => title only). */
+void ui_set_status(UiSdl *ui, const char *status);
+
+/* Generations stored by the history (first..last) and the current one, for the timeline. */
+void ui_set_timeline(UiSdl *ui, uint64_t first, uint64_t cur, uint64_t last);
+
+/* Renders the grid with colors (alive/dead), and the timeline below it. */
 void ui_render_grid(UiSdl *ui, const Grid *g);
 
 /* Polls SDL, returns an action (or UI_ACT_NONE). */
-UiAction ui_poll_action(bool *out_quit);
+UiAction ui_poll_action(UiSdl *ui, bool *out_quit);
 
 #endif /* UI_SDL_H */
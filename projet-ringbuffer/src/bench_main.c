@@ -7,6 +7,7 @@
 #include <string.h>
 #include <time.h>
 
+#include "engine.h"
 #include "grid.h"
 #include "history.h"
 #include "life.h"
@@ -17,12 +18,15 @@ typedef struct BenchArgs {
   int steps;
   unsigned int seed;
   size_t history_cap;
+  HistoryOptions history;
+  bool cluster; /* --fill cluster: soup in one corner only (uneven tile work) */
+  EngineOptions engine;
 } BenchArgs;
 
 static void usage(const char *prog) {
   fprintf(stderr,
-          "Usage: %s --width W --height H --steps S --seed N --history-cap C\n",
-          prog ? prog : "life_bench");
+          "Usage: %s --width W --height H --steps S --seed N --history-cap C %s [--fill uniform|cluster] %s\n",
+          prog ? prog : "life_bench", history_usage(), engine_usage());
 }
 
 static bool parse_int(const char *s, int *out) {
@@ -59,9 +63,17 @@ static bool parse_args(int argc, char **argv, BenchArgs *a) {
   a->height = 0;
   a->steps = 0;
   a->seed = 1;
-  a->history_cap = 512;
+  a->cluster = false;
+  a->history_cap = 0;
+  history_options_default(&a->history);
+  engine_options_default(&a->engine);
 
   for (int i = 1; i < argc; i++) {
+    int r = engine_parse_arg(&a->engine, argc, argv, &i);
+    if (r == 0) r = history_parse_arg(&a->history, argc, argv, &i);
+    if (r < 0) return false;
+    if (r > 0) continue;
+
     if (strcmp(argv[i], "--width") == 0 && i + 1 < argc) {
       if (!parse_int(argv[++i], &a->width) || a->width < 1) return false;
     } else if (strcmp(argv[i], "--height") == 0 && i + 1 < argc) {
@@ -72,6 +84,15 @@ static bool parse_args(int argc, char **argv, BenchArgs *a) {
       if (!parse_uint(argv[++i], &a->seed)) return false;
     } else if (strcmp(argv[i], "--history-cap") == 0 && i + 1 < argc) {
       if (!parse_size(argv[++i], &a->history_cap)) return false;
+    } else if (strcmp(argv[i], "--fill") == 0 && i + 1 < argc) {
+      const char *f = argv[++i];
+      if (strcmp(f, "uniform") == 0) {
+        a->cluster = false;
+      } else if (strcmp(f, "cluster") == 0) {
+        a->cluster = true;
+      } else {
+        return false;
+      }
     } else if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0) {
       usage(argv[0]);
       exit(0);
@@ -86,11 +107,12 @@ static uint64_t timespec_to_ns(const struct timespec *ts) {
   return (uint64_t)ts->tv_sec * 1000000000ull + (uint64_t)ts->tv_nsec;
 }
 
-static void fill_random(Grid *g, unsigned int seed) {
+/* Random soup in [0, w) x [0, h) of g, dead elsewhere. */
+static void fill_random(Grid *g, unsigned int seed, int w, int h) {
   if (!g || !g->cells) return;
   unsigned int s = seed;
-  for (int y = 0; y < g->h; y++) {
-    for (int x = 0; x < g->w; x++) {
+  for (int y = 0; y < h; y++) {
+    for (int x = 0; x < w; x++) {
       unsigned int r = (unsigned int)rand_r(&s);
       grid_set(g, x, y, (r % 4u == 0u) ? 1u : 0u);
     }
@@ -103,25 +125,51 @@ int main(int argc, char **argv) {
     usage(argv[0]);
     return 2;
   }
+  grid_set_pages(a.engine.pages);
 
   Grid init = {0};
-  if (!grid_create(&init, a.width, a.height)) {
+  if (!grid_create_padded(&init, a.width, a.height, 1)) {
     fprintf(stderr, "Allocation échouée (init)\n");
     return 1;
   }
-  fill_random(&init, a.seed);
+  if (a.cluster) {
+    fill_random(&init, a.seed, (a.width + 3) / 4, (a.height + 3) / 4);
+  } else {
+    fill_random(&init, a.seed, a.width, a.height);
+  }
+  if (!engine_configure(&a.engine)) {
+    fprintf(stderr, "Noyau '%s' non supporté par ce CPU\n", life_kernel_name(a.engine.kernel));
+    grid_free(&init);
+    return 1;
+  }
+  life_refresh_halo(&init);
 
   History hist;
-  if (!history_init(&hist, &init, a.history_cap)) {
+  if (!history_init_with(&hist, &init, a.history_cap, &a.history)) {
     fprintf(stderr, "Init historique échouée\n");
     grid_free(&init);
     return 1;
   }
   grid_free(&init);
 
-  Grid scratch_next = {0};
+  Engine eng;
+  if (!engine_supports_boundary(a.engine.kind, a.engine.boundary)) {
+    fprintf(stderr, "Moteur '%s' incompatible avec --boundary %s\n", engine_kind_name(a.engine.kind),
+            life_boundary_name(a.engine.boundary));
+    history_free(&hist);
+    return 1;
+  }
+  if (!engine_init(&eng, &a.engine, a.width, a.height)) {
+    fprintf(stderr, "Init moteur '%s' échouée\n", engine_kind_name(a.engine.kind));
+    history_free(&hist);
+    return 1;
+  }
+
+  (void)engine_observe(&eng, history_current(&hist), 0);
+  life_pool_reset_stats(&eng.pool);
 
   struct timespec t0, t1;
+  const size_t allocs0 = hist.allocs;
   (void)clock_gettime(CLOCK_MONOTONIC, &t0);
 
   const int nav_period = 128;
@@ -130,45 +178,86 @@ int main(int argc, char **argv) {
     if (!cur) {
       fprintf(stderr, "Historique invalide\n");
       history_free(&hist);
-      grid_free(&scratch_next);
+      engine_free(&eng);
       return 1;
     }
 
-    if (scratch_next.cells == NULL || scratch_next.w != cur->w || scratch_next.h != cur->h) {
-      grid_free(&scratch_next);
-      if (!grid_create(&scratch_next, cur->w, cur->h)) {
-        fprintf(stderr, "Allocation échouée (scratch)\n");
-        history_free(&hist);
-        return 1;
-      }
+    /* Step straight into the next history slot (no copy). */
+    Grid *next = history_reserve(&hist);
+    if (!next) {
+      fprintf(stderr, "history_reserve échoué\n");
+      history_free(&hist);
+      engine_free(&eng);
+      return 1;
     }
-
-    life_step(cur, &scratch_next);
-    if (!history_push(&hist, &scratch_next)) {
-      fprintf(stderr, "history_push échoué\n");
+    if (!engine_step(&eng, cur, next)) {
+      fprintf(stderr, "engine_step échoué\n");
       history_free(&hist);
-      grid_free(&scratch_next);
+      engine_free(&eng);
       return 1;
     }
+    (void)history_commit(&hist);
+
+    (void)engine_observe(&eng, next, (uint64_t)i + 1u);
 
     if (nav_period > 0 && (i % nav_period) == 0) {
       (void)history_back(&hist);
       (void)history_forward(&hist);
+      engine_invalidate(&eng); /* the current grid may have been rebuilt in place */
     }
   }
 
   (void)clock_gettime(CLOCK_MONOTONIC, &t1);
 
+  uint64_t period = 0, start = 0;
+  (void)engine_cycle(&eng, &period, &start);
+  char rule[24];
+  life_rule_format(life_rule(), rule, sizeof(rule));
+
+  /* Load balance: time each pool thread spent in jobs, and mean / max of those. */
+  char busy[512];
+  size_t busy_len = 0;
+  uint64_t busy_max = 0, busy_sum = 0;
+  busy[0] = '\0';
+  for (int t = 0; t < eng.pool.nthreads; t++) {
+    const uint64_t ns = life_pool_busy_ns(&eng.pool, t);
+    busy_sum += ns;
+    if (ns > busy_max) busy_max = ns;
+    if (busy_len + 24 < sizeof(busy)) {
+      int n = snprintf(busy + busy_len, sizeof(busy) - busy_len, "%s%.4f", t ? "," : "", (double)ns / 1e9);
+      if (n > 0) busy_len += (size_t)n;
+    }
+  }
+  double balance = (busy_max > 0) ? (double)busy_sum / (double)eng.pool.nthreads / (double)busy_max : 1.0;
+
+  /* Per NUMA node: bytes stepped per second of busy time (GB/s). */
+  char node_gbs[512];
+  size_t node_len = 0;
+  const int nodes = engine_numa_nodes(&eng);
+  node_gbs[0] = '\0';
+  for (int n = 0; n < nodes && node_len + 24 < sizeof(node_gbs); n++) {
+    int len = snprintf(node_gbs + node_len, sizeof(node_gbs) - node_len, "%s%.3f", n ? "," : "",
+                       engine_node_bandwidth(&eng, n) / 1e9);
+    if (len > 0) node_len += (size_t)len;
+  }
+
   uint64_t dt_ns = timespec_to_ns(&t1) - timespec_to_ns(&t0);
   double total_s = (double)dt_ns / 1e9;
   double steps_per_s = (double)a.steps / total_s;
   double ns_per_step = (double)dt_ns / (double)a.steps;
 
-  printf("RESULT impl=ring total_s=%.6f steps=%d steps_per_s=%.3f ns_per_step=%.1f width=%d height=%d seed=%u history_cap=%zu\n",
-         total_s, a.steps, steps_per_s, ns_per_step, a.width, a.height, a.seed, a.history_cap);
+  printf("RESULT impl=ring total_s=%.6f steps=%d steps_per_s=%.3f ns_per_step=%.1f width=%d height=%d seed=%u history_cap=%zu engine=%s kernel=%s threads=%d boundary=%s tiles_skipped=%.4f cycle_period=%llu cycle_gen=%llu rule=%s fill=%s schedule=%s busy_s=%s balance=%.3f numa=%s nodes=%d node_gbs=%s pages=%s convert_s=%.4f push_allocs=%.3f history=%s history_bytes=%zu history_keyframe=%d recomputed=%zu history_peak_bytes=%zu history_disk_bytes=%llu\n",
+         total_s, a.steps, steps_per_s, ns_per_step, a.width, a.height, a.seed, hist.cap,
+         engine_kind_name(a.engine.kind), life_kernel_name(life_active_kernel()), eng.pool.nthreads,
+         life_boundary_name(life_boundary()), engine_tiles_skipped(&eng), (unsigned long long)period,
+         (unsigned long long)start, rule, a.cluster ? "cluster" : "uniform", life_pool_schedule_name(eng.pool.schedule), busy, balance,
+         a.engine.numa ? "on" : "off", nodes, node_gbs, grid_pages_name(a.engine.pages),
+         (double)eng.convert_ns / 1e9, (double)(hist.allocs - allocs0) / (double)a.steps, history_mode_name(hist.mode), history_bytes(&hist),
+         hist.keyframe, hist.recomputed, history_peak_bytes(&hist),
+         (unsigned long long)history_disk_bytes(&hist));
 
+  engine_free(&eng);
   history_free(&hist);
-  grid_free(&scratch_next);
   return 0;
 }
 
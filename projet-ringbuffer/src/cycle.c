@@ -0,0 +1,223 @@
+#include "cycle.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+enum { CYCLE_MIN_TABLE = 64 };
+
+static const uint64_t CYCLE_K1 = 0x9e3779b97f4a7c15ull;
+static const uint64_t CYCLE_K2 = 0xc2b2ae3d27d4eb4full;
+
+static inline uint64_t rotl64(uint64_t v, int r) {
+  return (v << r) | (v >> (64 - r));
+}
+
+/* Murmur3 finalizer: every input bit affects every output bit. */
+static inline uint64_t fmix64(uint64_t h) {
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdull;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ull;
+  h ^= h >> 33;
+  return h;
+}
+
+static inline uint64_t lane_mix(uint64_t lane, uint64_t v) {
+  return rotl64(lane ^ (v * CYCLE_K2), 31) * CYCLE_K1;
+}
+
+bool cycle_init(CycleDetector *c, size_t window, uint64_t stride) {
+  if (!c || window == 0 || stride == 0) {
+    return false;
+  }
+  memset(c, 0, sizeof(*c));
+  size_t size = CYCLE_MIN_TABLE;
+  /* Up to 2 windows of entries between rebuilds: load factor <= 1/2. */
+  while (size < window * 4u) {
+    size *= 2u;
+  }
+  c->window = window;
+  c->stride = stride;
+  c->table_size = size;
+  c->ring_hash = (uint64_t *)malloc(window * sizeof(uint64_t));
+  c->ring_gen = (uint64_t *)malloc(window * sizeof(uint64_t));
+  c->keys = (uint64_t *)malloc(size * sizeof(uint64_t));
+  c->gens = (uint64_t *)malloc(size * sizeof(uint64_t));
+  if (!c->ring_hash || !c->ring_gen || !c->keys || !c->gens) {
+    cycle_free(c);
+    return false;
+  }
+  cycle_reset(c);
+  return true;
+}
+
+void cycle_free(CycleDetector *c) {
+  if (!c) return;
+  free(c->ring_hash);
+  free(c->ring_gen);
+  free(c->keys);
+  free(c->gens);
+  memset(c, 0, sizeof(*c));
+}
+
+void cycle_reset(CycleDetector *c) {
+  if (!c || !c->keys) return;
+  memset(c->gens, 0, c->table_size * sizeof(uint64_t));
+  memset(c->ring_gen, 0xff, c->window * sizeof(uint64_t));
+  c->inserted = 0;
+  c->ref_hash = 0;
+  c->ref_gen = 0;
+  c->ref_span = 0;
+  c->period = 0;
+  c->start = 0;
+}
+
+bool cycle_wants(const CycleDetector *c, uint64_t gen) {
+  if (!c || !c->keys || c->period != 0) {
+    return false;
+  }
+  return (c->ref_span != 0 || gen % c->stride == 0);
+}
+
+bool cycle_refining(const CycleDetector *c) {
+  return (c && c->period == 0 && c->ref_span != 0);
+}
+
+static void table_put(CycleDetector *c, uint64_t hash, uint64_t gen) {
+  const size_t mask = c->table_size - 1u;
+  size_t i = (size_t)fmix64(hash) & mask;
+  while (c->gens[i] != 0 && c->keys[i] != hash) {
+    i = (i + 1u) & mask;
+  }
+  c->keys[i] = hash;
+  c->gens[i] = gen + 1u;
+}
+
+/* Keeps only the generations still in the ring (older ones can no longer match). */
+static void table_rebuild(CycleDetector *c) {
+  memset(c->gens, 0, c->table_size * sizeof(uint64_t));
+  for (size_t i = 0; i < c->window; i++) {
+    if (c->ring_gen[i] != UINT64_MAX) {
+      table_put(c, c->ring_hash[i], c->ring_gen[i]);
+    }
+  }
+  c->inserted = 0;
+}
+
+bool cycle_observe(CycleDetector *c, uint64_t hash, uint64_t gen) {
+  if (!c || !c->keys || c->period != 0) {
+    return false;
+  }
+  if (c->ref_span != 0) {
+    if (hash == c->ref_hash && gen > c->ref_gen) {
+      c->period = gen - c->ref_gen;
+      c->start = c->ref_gen;
+      return true;
+    }
+    if (gen - c->ref_gen <= c->ref_span) {
+      return false;
+    }
+    /* The sampled repeat did not hold (hash collision): back to sampling. */
+    c->ref_span = 0;
+    if (gen % c->stride != 0) {
+      return false;
+    }
+  }
+
+  const size_t mask = c->table_size - 1u;
+  for (size_t i = (size_t)fmix64(hash) & mask; c->gens[i] != 0; i = (i + 1u) & mask) {
+    if (c->keys[i] != hash) {
+      continue;
+    }
+    const uint64_t seen = c->gens[i] - 1u;
+    if (seen < gen && gen - seen <= c->window * c->stride) {
+      /* The period divides gen - seen: measure it exactly from here. */
+      c->ref_hash = hash;
+      c->ref_gen = gen;
+      c->ref_span = gen - seen;
+      return false;
+    }
+    break;
+  }
+  if (c->inserted >= c->window) {
+    table_rebuild(c);
+  }
+  const size_t slot = (size_t)((gen / c->stride) % c->window);
+  table_put(c, hash, gen);
+  c->inserted++;
+  c->ring_hash[slot] = hash;
+  c->ring_gen[slot] = gen;
+  return false;
+}
+
+/* The 64 cells (0/1 bytes) at p as one bit each. */
+static inline uint64_t fold64(const uint8_t *p) {
+#ifdef __SSE2__
+  uint64_t folded = 0;
+  for (int j = 0; j < 4; j++) {
+    __m128i v = _mm_loadu_si128((const __m128i *)(p + 16 * j));
+    folded |= (uint64_t)(uint32_t)_mm_movemask_epi8(_mm_slli_epi16(v, 7)) << (16 * j);
+  }
+  return folded;
+#else
+  /* Byte i of word j lands in bit 8*i + j. */
+  uint64_t folded = 0;
+  for (int j = 0; j < 8; j++) {
+    uint64_t v;
+    memcpy(&v, p + 8 * j, sizeof(v));
+    folded |= v << j;
+  }
+  return folded;
+#endif
+}
+
+uint64_t cycle_hash_grid(const Grid *g) {
+  if (!g || !g->cells) {
+    return 0;
+  }
+  /* Four independent lanes, one multiply per 64 cells. */
+  uint64_t l0 = CYCLE_K1, l1 = CYCLE_K2, l2 = ~CYCLE_K1, l3 = ~CYCLE_K2;
+  for (int y = 0; y < g->h; y++) {
+    const uint8_t *row = grid_row(g, y);
+    int x = 0;
+    for (; x + 256 <= g->w; x += 256) {
+      l0 = (l0 ^ fold64(row + x)) * CYCLE_K2;
+      l1 = (l1 ^ fold64(row + x + 64)) * CYCLE_K2;
+      l2 = (l2 ^ fold64(row + x + 128)) * CYCLE_K2;
+      l3 = (l3 ^ fold64(row + x + 192)) * CYCLE_K2;
+    }
+    uint64_t tail = (uint64_t)y << 32;
+    for (; x + 64 <= g->w; x += 64) {
+      tail = lane_mix(tail, fold64(row + x));
+    }
+    for (int i = 0; x < g->w; x++, i++) {
+      tail ^= (uint64_t)row[x] << i;
+    }
+    l0 = lane_mix(l0, tail);
+  }
+  uint64_t h = ((uint64_t)(uint32_t)g->w << 32) | (uint32_t)g->h;
+  h = fmix64(h ^ l0);
+  h = fmix64(h ^ l1);
+  h = fmix64(h ^ l2);
+  return fmix64(h ^ l3);
+}
+
+uint64_t cycle_hash_words(const uint64_t *words, size_t n) {
+  uint64_t h = CYCLE_K2 ^ n;
+  for (size_t i = 0; i < n; i++) {
+    h = lane_mix(h, words[i]);
+  }
+  return fmix64(h);
+}
+
+uint64_t cycle_hash_set(const uint64_t *keys, size_t n) {
+  uint64_t h = n * CYCLE_K1;
+  for (size_t i = 0; i < n; i++) {
+    h += fmix64(keys[i] ^ CYCLE_K2);
+  }
+  return fmix64(h);
+}
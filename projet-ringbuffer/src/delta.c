@@ -0,0 +1,92 @@
+#include "delta.h"
+
+#include <string.h>
+
+static uint8_t *put_varint(uint8_t *p, size_t v) {
+  while (v >= 0x80u) {
+    *p++ = (uint8_t)(v | 0x80u);
+    v >>= 7;
+  }
+  *p++ = (uint8_t)v;
+  return p;
+}
+
+static bool get_varint(const uint8_t **p, const uint8_t *end, size_t *out) {
+  size_t v = 0;
+  for (int shift = 0; *p < end && shift < 64; shift += 7) {
+    const uint8_t byte = *(*p)++;
+    v |= (size_t)(byte & 0x7fu) << shift;
+    if (!(byte & 0x80u)) {
+      *out = v;
+      return true;
+    }
+  }
+  return false;
+}
+
+size_t delta_bound(size_t nwords) {
+  /* Runs alternate, and a literal run follows at least one zero word except
+   * the first: at most nwords / 2 + 1 runs of two varints (10 bytes at most). */
+  return nwords * sizeof(uint64_t) + (nwords / 2u + 1u) * 20u;
+}
+
+size_t delta_encode(const uint64_t *a, const uint64_t *b, size_t nwords, uint8_t *out) {
+  uint8_t *p = out;
+  size_t i = 0;
+  while (i < nwords) {
+    const size_t zero_start = i;
+    while (i < nwords && a[i] == b[i]) {
+      i++;
+    }
+    if (i == nwords) {
+      break; /* trailing zeros are implicit */
+    }
+    const size_t lit_start = i;
+    while (i < nwords && a[i] != b[i]) {
+      i++;
+    }
+    p = put_varint(p, lit_start - zero_start);
+    p = put_varint(p, i - lit_start);
+    for (size_t k = lit_start; k < i; k++) {
+      const uint64_t x = a[k] ^ b[k];
+      memcpy(p, &x, sizeof(x));
+      p += sizeof(x);
+    }
+  }
+  return (size_t)(p - out);
+}
+
+bool delta_apply(const uint8_t *d, size_t size, uint64_t *bits, size_t nwords, Grid *g, int words) {
+  if (size == 0) {
+    return true; /* no change (d may be NULL) */
+  }
+  const uint8_t *p = d;
+  const uint8_t *end = d + size;
+  size_t i = 0;
+  while (p < end) {
+    size_t skip = 0;
+    size_t count = 0;
+    if (!get_varint(&p, end, &skip) || !get_varint(&p, end, &count)) {
+      return false;
+    }
+    if (skip > nwords - i || count > nwords - i - skip || count > (size_t)(end - p) / sizeof(uint64_t)) {
+      return false;
+    }
+    i += skip;
+    for (size_t k = 0; k < count; k++, i++) {
+      uint64_t x;
+      memcpy(&x, p, sizeof(x));
+      p += sizeof(x);
+      bits[i] ^= x;
+      if (g) {
+        uint8_t *row = grid_row(g, (int)(i / (size_t)words));
+        const int x0 = (int)(i % (size_t)words) * 64;
+        while (x) {
+          row[x0 + __builtin_ctzll(x)] ^= 1u;
+          x &= x - 1u;
+        }
+      }
+    }
+  }
+  return true;
+}
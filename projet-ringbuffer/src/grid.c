@@ -1,54 +1,171 @@
+#define _GNU_SOURCE
+
 #include "grid.h"
 
 #include <limits.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+
+#define GRID_HUGE_PAGE ((size_t)2 << 20)
 
-static bool grid_valid_dims(int w, int h) {
-  return (w > 0 && h > 0);
+static GridPages g_pages = GRID_PAGES_DEFAULT;
+
+void grid_set_pages(GridPages p) {
+  g_pages = p;
 }
 
-static bool grid_count_ok(int w, int h, size_t *out_count) {
-  if (!grid_valid_dims(w, h)) {
+GridPages grid_pages(void) {
+  return g_pages;
+}
+
+bool grid_parse_pages(const char *s, GridPages *out) {
+  if (!s || !out) return false;
+  if (strcmp(s, "default") == 0) {
+    *out = GRID_PAGES_DEFAULT;
+  } else if (strcmp(s, "thp") == 0) {
+    *out = GRID_PAGES_THP;
+  } else if (strcmp(s, "hugetlb") == 0) {
+    *out = GRID_PAGES_HUGETLB;
+  } else {
     return false;
   }
-  size_t ww = (size_t)w;
-  size_t hh = (size_t)h;
-  if (ww != 0 && hh > (SIZE_MAX / ww)) {
+  return true;
+}
+
+const char *grid_pages_name(GridPages p) {
+  switch (p) {
+    case GRID_PAGES_DEFAULT: return "default";
+    case GRID_PAGES_THP: return "thp";
+    case GRID_PAGES_HUGETLB: return "hugetlb";
+  }
+  return "?";
+}
+
+static bool grid_valid_dims(int w, int h, int pad) {
+  return (w > 0 && h > 0 && pad >= 0 && pad <= (INT_MAX - w) / 2 && pad <= (INT_MAX - h) / 2 &&
+          w + 2 * pad <= INT_MAX - (GRID_ALIGN - 1));
+}
+
+static size_t round_up(size_t n, size_t a) {
+  return (n + a - 1u) / a * a;
+}
+
+/*
+ * Layout of a w*h grid with a halo of pad cells: row pitch, offset of cell (0,0)
+ * (pad halo rows, then pad cells rounded up to GRID_ALIGN) and buffer size. Row
+ * y's right halo ends before row y+1's left halo starts since stride >= w + 2*pad.
+ */
+static bool grid_layout(int w, int h, int pad, int *out_stride, size_t *out_offset, size_t *out_bytes) {
+  if (!grid_valid_dims(w, h, pad)) {
+    return false;
+  }
+  const size_t stride = round_up((size_t)w + 2u * (size_t)pad, GRID_ALIGN);
+  const size_t lead = round_up((size_t)pad, GRID_ALIGN);
+  const size_t rows = (size_t)h + 2u * (size_t)pad;
+  if (rows > (SIZE_MAX - lead) / stride) {
     return false;
   }
-  *out_count = ww * hh;
+  *out_stride = (int)stride;
+  *out_offset = (size_t)pad * stride + lead;
+  *out_bytes = rows * stride + lead;
   return true;
 }
 
-bool grid_create(Grid *g, int w, int h) {
+/*
+ * Zeroed, GRID_ALIGN-aligned buffer of *bytes bytes. Large buffers are fresh
+ * anonymous mappings (zero pages not touched yet, so the first writer places
+ * them: see engine_place), with huge pages as g_pages asks; *bytes is then the
+ * mapped length.
+ */
+static uint8_t *grid_alloc(size_t *bytes, bool *mapped) {
+  *mapped = false;
+  if (*bytes < (size_t)GRID_MAP_MIN) {
+    uint8_t *mem = (uint8_t *)aligned_alloc(GRID_ALIGN, *bytes);
+    if (mem) {
+      memset(mem, 0, *bytes);
+    }
+    return mem;
+  }
+  void *mem = MAP_FAILED;
+#ifdef MAP_HUGETLB
+  if (g_pages == GRID_PAGES_HUGETLB) {
+    const size_t len = round_up(*bytes, GRID_HUGE_PAGE);
+    mem = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (mem != MAP_FAILED) {
+      *bytes = len;
+    }
+  }
+#endif
+  if (mem == MAP_FAILED) {
+    mem = mmap(NULL, *bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED) {
+      return NULL;
+    }
+#ifdef MADV_HUGEPAGE
+    /* hugetlb without reserved pages falls back here. */
+    if (g_pages != GRID_PAGES_DEFAULT && *bytes >= GRID_HUGE_PAGE) {
+      (void)madvise(mem, *bytes, MADV_HUGEPAGE);
+    }
+#endif
+  }
+  *mapped = true;
+  return (uint8_t *)mem;
+}
+
+static void grid_release(uint8_t *mem, size_t bytes, bool mapped) {
+  if (mapped) {
+    (void)munmap(mem, bytes);
+  } else {
+    free(mem);
+  }
+}
+
+bool grid_create_padded(Grid *g, int w, int h, int pad) {
   if (!g) {
     return false;
   }
-  size_t count = 0;
-  if (!grid_count_ok(w, h, &count)) {
+  int stride = 0;
+  size_t offset = 0;
+  size_t bytes = 0;
+  if (!grid_layout(w, h, pad, &stride, &offset, &bytes)) {
     return false;
   }
 
-  uint8_t *cells = (uint8_t *)calloc(count, sizeof(uint8_t));
-  if (!cells) {
+  bool mapped = false;
+  uint8_t *mem = grid_alloc(&bytes, &mapped);
+  if (!mem) {
     return false;
   }
 
   g->w = w;
   g->h = h;
-  g->cells = cells;
+  g->pad = pad;
+  g->stride = stride;
+  g->mem = mem;
+  g->cells = mem + offset;
+  g->bytes = bytes;
+  g->mapped = mapped;
   return true;
 }
 
+bool grid_create(Grid *g, int w, int h) {
+  return grid_create_padded(g, w, h, 0);
+}
+
 void grid_free(Grid *g) {
   if (!g) {
     return;
   }
-  free(g->cells);
+  grid_release(g->mem, g->bytes, g->mapped);
+  g->mem = NULL;
   g->cells = NULL;
   g->w = 0;
   g->h = 0;
+  g->stride = 0;
+  g->pad = 0;
+  g->bytes = 0;
+  g->mapped = false;
 }
 
 void grid_destroy(Grid *g) {
@@ -59,12 +176,20 @@ void grid_destroy(Grid *g) {
   free(g);
 }
 
+/* First byte of the top halo row; grid_span bytes from there cover every cell and halo. */
+static uint8_t *grid_first(const Grid *g) {
+  return g->cells - (ptrdiff_t)g->pad * g->stride - g->pad;
+}
+
+static size_t grid_span(const Grid *g) {
+  return (size_t)(g->h - 1 + 2 * g->pad) * (size_t)g->stride + (size_t)g->w + 2u * (size_t)g->pad;
+}
+
 void grid_clear(Grid *g) {
   if (!g || !g->cells) {
     return;
   }
-  size_t count = (size_t)g->w * (size_t)g->h;
-  memset(g->cells, 0, count * sizeof(uint8_t));
+  memset(grid_first(g), 0, grid_span(g));
 }
 
 uint8_t grid_get(const Grid *g, int x, int y) {
@@ -74,7 +199,7 @@ uint8_t grid_get(const Grid *g, int x, int y) {
   if (x < 0 || y < 0 || x >= g->w || y >= g->h) {
     return 0;
   }
-  return g->cells[(size_t)y * (size_t)g->w + (size_t)x];
+  return g->cells[(ptrdiff_t)y * g->stride + x];
 }
 
 void grid_set(Grid *g, int x, int y, uint8_t v) {
@@ -84,7 +209,74 @@ void grid_set(Grid *g, int x, int y, uint8_t v) {
   if (x < 0 || y < 0 || x >= g->w || y >= g->h) {
     return;
   }
-  g->cells[(size_t)y * (size_t)g->w + (size_t)x] = (v ? 1u : 0u);
+  g->cells[(ptrdiff_t)y * g->stride + x] = (v ? 1u : 0u);
+}
+
+void grid_clear_halo(Grid *g) {
+  if (!g || !g->cells || g->pad == 0) {
+    return;
+  }
+  const int p = g->pad;
+  for (int y = -p; y < g->h + p; y++) {
+    uint8_t *row = g->cells + (ptrdiff_t)y * g->stride;
+    if (y < 0 || y >= g->h) {
+      memset(row - p, 0, (size_t)g->w + 2u * (size_t)p);
+    } else {
+      memset(row - p, 0, (size_t)p);
+      memset(row + g->w, 0, (size_t)p);
+    }
+  }
+}
+
+void grid_wrap_halo(Grid *g) {
+  if (!g || !g->cells || g->pad == 0) {
+    return;
+  }
+  const int p = g->pad;
+  const int w = g->w;
+  const int h = g->h;
+
+  /* Ghost columns of the live rows. */
+  for (int y = 0; y < h; y++) {
+    uint8_t *row = grid_row(g, y);
+    if (p <= w) {
+      memcpy(row - p, row + w - p, (size_t)p);
+      memcpy(row + w, row, (size_t)p);
+    } else {
+      for (int k = 1; k <= p; k++) {
+        row[-k] = row[((-k % w) + w) % w];
+        row[w - 1 + k] = row[(k - 1) % w];
+      }
+    }
+  }
+
+  /* Ghost rows: whole padded rows, so the corners wrap too. */
+  const size_t span = (size_t)w + 2u * (size_t)p;
+  for (int k = 1; k <= p; k++) {
+    int src_top = ((-k % h) + h) % h;
+    int src_bot = (k - 1) % h;
+    memcpy(g->cells - (ptrdiff_t)k * g->stride - p, grid_row(g, src_top) - p, span);
+    memcpy(grid_row(g, h - 1 + k) - p, grid_row(g, src_bot) - p, span);
+  }
+}
+
+/* Reallocates g as (new_w, new_h, new_pad), preserving the overlap. */
+static bool grid_relayout(Grid *g, int new_w, int new_h, int new_pad) {
+  Grid tmp = {0};
+  if (!grid_create_padded(&tmp, new_w, new_h, new_pad)) {
+    return false;
+  }
+
+  int copy_w = (g->w < new_w) ? g->w : new_w;
+  int copy_h = (g->h < new_h) ? g->h : new_h;
+
+  for (int y = 0; y < copy_h; y++) {
+    memcpy(grid_row(&tmp, y), grid_row(g, y), (size_t)copy_w * sizeof(uint8_t));
+  }
+
+  grid_release(g->mem, g->bytes, g->mapped);
+  *g = tmp;
+  return true;
 }
 
 bool grid_resize(Grid *g, int new_w, int new_h) {
@@ -92,36 +284,45 @@ bool grid_resize(Grid *g, int new_w, int new_h) {
     return false;
   }
 
-  size_t new_count = 0;
-  if (!grid_count_ok(new_w, new_h, &new_count)) {
+  if (!grid_valid_dims(new_w, new_h, g->pad)) {
     return false;
   }
 
   /* Si grille non initialisée, agir comme create. */
   if (!g->cells) {
+    int pad = g->pad;
     g->w = 0;
     g->h = 0;
-    return grid_create(g, new_w, new_h);
+    return grid_create_padded(g, new_w, new_h, pad);
   }
 
-  uint8_t *new_cells = (uint8_t *)calloc(new_count, sizeof(uint8_t));
-  if (!new_cells) {
+  return grid_relayout(g, new_w, new_h, g->pad);
+}
+
+bool grid_set_pad(Grid *g, int pad) {
+  if (!g || !g->cells) {
     return false;
   }
-
-  int copy_w = (g->w < new_w) ? g->w : new_w;
-  int copy_h = (g->h < new_h) ? g->h : new_h;
-
-  for (int y = 0; y < copy_h; y++) {
-    const uint8_t *src_row = &g->cells[(size_t)y * (size_t)g->w];
-    uint8_t *dst_row = &new_cells[(size_t)y * (size_t)new_w];
-    memcpy(dst_row, src_row, (size_t)copy_w * sizeof(uint8_t));
+  if (pad == g->pad) {
+    return true;
   }
+  return grid_relayout(g, g->w, g->h, pad);
+}
 
-  free(g->cells);
-  g->cells = new_cells;
-  g->w = new_w;
-  g->h = new_h;
+bool grid_copy(Grid *dst, const Grid *src) {
+  if (!dst || !src || !dst->cells || !src->cells) {
+    return false;
+  }
+  if (dst->w != src->w || dst->h != src->h) {
+    return false;
+  }
+  if (dst->stride == src->stride && dst->pad == src->pad) {
+    memcpy(grid_first(dst), grid_first(src), grid_span(src));
+    return true;
+  }
+  for (int y = 0; y < src->h; y++) {
+    memcpy(grid_row(dst, y), grid_row(src, y), (size_t)src->w * sizeof(uint8_t));
+  }
   return true;
 }
 
@@ -133,17 +334,14 @@ Grid *grid_clone(const Grid *src) {
   if (!g) {
     return NULL;
   }
-  g->w = 0;
-  g->h = 0;
-  g->cells = NULL;
+  *g = (Grid){0};
 
-  if (!grid_create(g, src->w, src->h)) {
+  if (!grid_create_padded(g, src->w, src->h, src->pad)) {
     free(g);
     return NULL;
   }
 
-  size_t count = (size_t)src->w * (size_t)src->h;
-  memcpy(g->cells, src->cells, count * sizeof(uint8_t));
+  (void)grid_copy(g, src);
   return g;
 }
 
@@ -155,3 +353,66 @@ void grid_swap(Grid *a, Grid *b) {
   *a = *b;
   *b = tmp;
 }
+
+bool grid_slab_create(GridSlab *s, size_t count, int w, int h, int pad) {
+  if (!s || count == 0) {
+    return false;
+  }
+  *s = (GridSlab){0};
+  size_t slot_bytes = 0;
+  if (!grid_layout(w, h, pad, &s->stride, &s->offset, &slot_bytes)) {
+    return false;
+  }
+  if (count > SIZE_MAX / slot_bytes) {
+    return false;
+  }
+  size_t bytes = count * slot_bytes;
+  bool mapped = false;
+  uint8_t *mem = grid_alloc(&bytes, &mapped);
+  if (!mem) {
+    return false;
+  }
+  s->w = w;
+  s->h = h;
+  s->pad = pad;
+  s->count = count;
+  s->slot_bytes = slot_bytes;
+  s->mem = mem;
+  s->bytes = bytes;
+  s->mapped = mapped;
+  return true;
+}
+
+void grid_slab_free(GridSlab *s) {
+  if (!s) {
+    return;
+  }
+  if (s->mem) {
+    grid_release(s->mem, s->bytes, s->mapped);
+  }
+  *s = (GridSlab){0};
+}
+
+void grid_slab_view(const GridSlab *s, size_t i, Grid *out) {
+  if (!s || !out || !s->mem || i >= s->count) {
+    return;
+  }
+  out->w = s->w;
+  out->h = s->h;
+  out->pad = s->pad;
+  out->stride = s->stride;
+  out->cells = s->mem + i * s->slot_bytes + s->offset;
+  out->mem = NULL;
+  out->bytes = 0;
+  out->mapped = false;
+}
+
+size_t grid_slab_slot_bytes(int w, int h, int pad) {
+  int stride = 0;
+  size_t offset = 0;
+  size_t bytes = 0;
+  if (!grid_layout(w, h, pad, &stride, &offset, &bytes)) {
+    return 0;
+  }
+  return bytes;
+}
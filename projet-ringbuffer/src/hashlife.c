@@ -0,0 +1,477 @@
+#include "hashlife.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "life.h"
+
+/*
+ * Level 0 nodes are the two cells (static); a level L >= 1 node is 4 children
+ * of level L-1. res caches successor(node, res_j) (res_j < 0 => none).
+ */
+typedef struct HLNode {
+  struct HLNode *nw;
+  struct HLNode *ne;
+  struct HLNode *sw;
+  struct HLNode *se;
+  struct HLNode *next; /* hash chain, or free list */
+  struct HLNode *res;
+  int8_t res_j;
+  uint8_t level;
+  uint8_t mark;
+  uint8_t alive;       /* level 0 only */
+} HLNode;
+
+enum { HL_SLAB_NODES = 1 << 14 };
+
+typedef struct HLSlab {
+  struct HLSlab *next;
+  HLNode nodes[HL_SLAB_NODES];
+} HLSlab;
+
+enum { HL_MAX_LEVEL = 62 }; /* root side and world coordinates fit in int64_t */
+
+static HLNode hl_dead = {NULL, NULL, NULL, NULL, NULL, NULL, -1, 0, 1, 0};
+static HLNode hl_alive = {NULL, NULL, NULL, NULL, NULL, NULL, -1, 0, 1, 1};
+
+static const size_t HL_DEFAULT_CAP = (size_t)512u << 20;
+
+static size_t hash_children(const HLNode *nw, const HLNode *ne, const HLNode *sw, const HLNode *se) {
+  uint64_t h = (uint64_t)(uintptr_t)nw;
+  h = h * 0x9e3779b97f4a7c15ull + (uint64_t)(uintptr_t)ne;
+  h = h * 0x9e3779b97f4a7c15ull + (uint64_t)(uintptr_t)sw;
+  h = h * 0x9e3779b97f4a7c15ull + (uint64_t)(uintptr_t)se;
+  h ^= h >> 29;
+  return (size_t)h;
+}
+
+size_t hashlife_mem_bytes(const HashLife *hl) {
+  if (!hl) return 0;
+  return hl->nodes * sizeof(HLNode) + hl->table_size * sizeof(HLNode *);
+}
+
+enum { HL_MIN_TABLE = 1 << 16 };
+
+/* Rehashes every node into size buckets (power of two). */
+static bool table_resize(HashLife *hl, size_t size) {
+  HLNode **t = (HLNode **)calloc(size, sizeof(HLNode *));
+  if (!t) {
+    return false;
+  }
+  for (size_t i = 0; i < hl->table_size; i++) {
+    HLNode *n = hl->table[i];
+    while (n) {
+      HLNode *nx = n->next;
+      size_t b = hash_children(n->nw, n->ne, n->sw, n->se) & (size - 1u);
+      n->next = t[b];
+      t[b] = n;
+      n = nx;
+    }
+  }
+  free(hl->table);
+  hl->table = t;
+  hl->table_size = size;
+  return true;
+}
+
+static bool table_grow(HashLife *hl) {
+  return table_resize(hl, hl->table_size ? hl->table_size * 2u : (size_t)HL_MIN_TABLE);
+}
+
+static HLNode *node_alloc(HashLife *hl) {
+  if (!hl->free_list) {
+    HLSlab *s = (HLSlab *)malloc(sizeof(HLSlab));
+    if (!s) {
+      return NULL;
+    }
+    s->next = hl->slabs;
+    hl->slabs = s;
+    for (size_t i = 0; i < HL_SLAB_NODES; i++) {
+      s->nodes[i].next = hl->free_list;
+      hl->free_list = &s->nodes[i];
+    }
+  }
+  HLNode *n = hl->free_list;
+  hl->free_list = n->next;
+  return n;
+}
+
+/* Hash-consed node with these children (NULL if out of memory). */
+static HLNode *join(HashLife *hl, HLNode *nw, HLNode *ne, HLNode *sw, HLNode *se) {
+  if (!nw || !ne || !sw || !se) {
+    return NULL;
+  }
+  if (hl->nodes >= hl->table_size && !table_grow(hl)) {
+    return NULL;
+  }
+  size_t b = hash_children(nw, ne, sw, se) & (hl->table_size - 1u);
+  for (HLNode *n = hl->table[b]; n; n = n->next) {
+    if (n->nw == nw && n->ne == ne && n->sw == sw && n->se == se) {
+      return n;
+    }
+  }
+  HLNode *n = node_alloc(hl);
+  if (!n) {
+    return NULL;
+  }
+  n->nw = nw;
+  n->ne = ne;
+  n->sw = sw;
+  n->se = se;
+  n->res = NULL;
+  n->res_j = -1;
+  n->level = (uint8_t)(nw->level + 1);
+  n->mark = 0;
+  n->alive = 0;
+  n->next = hl->table[b];
+  hl->table[b] = n;
+  hl->nodes++;
+  return n;
+}
+
+static HLNode *empty_node(HashLife *hl, int level) {
+  if (level < 0 || level > HL_MAX_LEVEL) {
+    return NULL;
+  }
+  if (!hl->empty[level]) {
+    HLNode *e = empty_node(hl, level - 1);
+    hl->empty[level] = join(hl, e, e, e, e);
+  }
+  return hl->empty[level];
+}
+
+static bool is_empty(HashLife *hl, HLNode *n) {
+  return n == empty_node(hl, n->level);
+}
+
+/* Middle level L-1 node of a level L node. */
+static HLNode *centre(HashLife *hl, HLNode *n) {
+  return join(hl, n->nw->se, n->ne->sw, n->sw->ne, n->se->nw);
+}
+
+/* Middle of two horizontally adjacent nodes w|e (same level). */
+static HLNode *centre_h(HashLife *hl, HLNode *w, HLNode *e) {
+  return join(hl, w->ne, e->nw, w->se, e->sw);
+}
+
+/* Middle of two vertically adjacent nodes n/s (same level). */
+static HLNode *centre_v(HashLife *hl, HLNode *n, HLNode *s) {
+  return join(hl, n->sw, n->se, s->nw, s->ne);
+}
+
+static uint8_t cell_rule(uint8_t alive, int n) {
+  const LifeRule *r = life_rule();
+  return alive ? r->survive[n] : r->birth[n];
+}
+
+/* Level 2 base case: one generation of the central 2x2 cells of a 4x4 node. */
+static HLNode *base_step(HashLife *hl, HLNode *n) {
+  uint8_t c[4][4];
+  HLNode *q[2][2] = {{n->nw, n->ne}, {n->sw, n->se}};
+  for (int qy = 0; qy < 2; qy++) {
+    for (int qx = 0; qx < 2; qx++) {
+      HLNode *s = q[qy][qx];
+      c[qy * 2][qx * 2] = s->nw->alive;
+      c[qy * 2][qx * 2 + 1] = s->ne->alive;
+      c[qy * 2 + 1][qx * 2] = s->sw->alive;
+      c[qy * 2 + 1][qx * 2 + 1] = s->se->alive;
+    }
+  }
+  HLNode *out[4];
+  for (int y = 1; y <= 2; y++) {
+    for (int x = 1; x <= 2; x++) {
+      int cnt = 0;
+      for (int dy = -1; dy <= 1; dy++) {
+        for (int dx = -1; dx <= 1; dx++) {
+          if (dx || dy) cnt += c[y + dy][x + dx];
+        }
+      }
+      out[(y - 1) * 2 + (x - 1)] = cell_rule(c[y][x], cnt) ? &hl_alive : &hl_dead;
+    }
+  }
+  return join(hl, out[0], out[1], out[2], out[3]);
+}
+
+/*
+ * Center half (level L-1) of n advanced by 2^j generations, 0 <= j <= L-2.
+ * j == L-2 steps twice by 2^(L-3) (nine overlapping sub-results, then four);
+ * smaller j takes the nine centers as they are and only steps the four.
+ */
+static HLNode *successor(HashLife *hl, HLNode *n, int j) {
+  if (n->res && n->res_j == j) {
+    return n->res;
+  }
+  const int L = n->level;
+  HLNode *r;
+  if (is_empty(hl, n)) {
+    r = empty_node(hl, L - 1);
+  } else if (L == 2) {
+    r = base_step(hl, n);
+  } else {
+    HLNode *m[9];
+    m[0] = n->nw;
+    m[1] = centre_h(hl, n->nw, n->ne);
+    m[2] = n->ne;
+    m[3] = centre_v(hl, n->nw, n->sw);
+    m[4] = centre(hl, n);
+    m[5] = centre_v(hl, n->ne, n->se);
+    m[6] = n->sw;
+    m[7] = centre_h(hl, n->sw, n->se);
+    m[8] = n->se;
+
+    const bool full = (j == L - 2);
+    const int jj = full ? L - 3 : j;
+    for (int i = 0; i < 9; i++) {
+      if (!m[i]) return NULL;
+      m[i] = full ? successor(hl, m[i], jj) : centre(hl, m[i]);
+      if (!m[i]) return NULL;
+    }
+
+    HLNode *q[4];
+    q[0] = join(hl, m[0], m[1], m[3], m[4]);
+    q[1] = join(hl, m[1], m[2], m[4], m[5]);
+    q[2] = join(hl, m[3], m[4], m[6], m[7]);
+    q[3] = join(hl, m[4], m[5], m[7], m[8]);
+    for (int i = 0; i < 4; i++) {
+      if (!q[i]) return NULL;
+      q[i] = successor(hl, q[i], jj);
+      if (!q[i]) return NULL;
+    }
+    r = join(hl, q[0], q[1], q[2], q[3]);
+  }
+  if (r) {
+    n->res = r;
+    n->res_j = (int8_t)j;
+  }
+  return r;
+}
+
+static void mark_node(HLNode *n) {
+  if (!n || n->mark) {
+    return;
+  }
+  n->mark = 1;
+  mark_node(n->nw);
+  mark_node(n->ne);
+  mark_node(n->sw);
+  mark_node(n->se);
+}
+
+/* Keeps the nodes reachable from the root (and the empty nodes); drops stale memos. */
+static void collect(HashLife *hl) {
+  mark_node(hl->root);
+  for (int l = 0; l <= HL_MAX_LEVEL; l++) {
+    mark_node(hl->empty[l]);
+  }
+  for (size_t b = 0; b < hl->table_size; b++) {
+    HLNode **link = &hl->table[b];
+    while (*link) {
+      HLNode *n = *link;
+      if (!n->mark) {
+        *link = n->next;
+        n->next = hl->free_list;
+        hl->free_list = n;
+        hl->nodes--;
+      } else {
+        link = &n->next;
+      }
+    }
+  }
+  for (size_t b = 0; b < hl->table_size; b++) {
+    for (HLNode *n = hl->table[b]; n; n = n->next) {
+      if (n->res && n->res->level > 0 && !n->res->mark) {
+        n->res = NULL;
+        n->res_j = -1;
+      }
+    }
+  }
+  for (size_t b = 0; b < hl->table_size; b++) {
+    for (HLNode *n = hl->table[b]; n; n = n->next) {
+      n->mark = 0;
+    }
+  }
+  size_t size = hl->table_size;
+  while (size > HL_MIN_TABLE && hl->nodes < size / 4u) {
+    size /= 2u;
+  }
+  if (size != hl->table_size) {
+    (void)table_resize(hl, size); /* on failure the larger table stays valid */
+  }
+  hl->gc_runs++;
+}
+
+bool hashlife_init(HashLife *hl, size_t mem_cap) {
+  if (!hl) {
+    return false;
+  }
+  memset(hl, 0, sizeof(*hl));
+  hl->mem_cap = mem_cap ? mem_cap : HL_DEFAULT_CAP;
+  hl->max_jump = HL_MAX_LEVEL - 3;
+  hl->empty[0] = &hl_dead;
+  if (!table_grow(hl)) {
+    return false;
+  }
+  hl->root = empty_node(hl, 3);
+  hl->level = 3;
+  return hl->root != NULL;
+}
+
+void hashlife_free(HashLife *hl) {
+  if (!hl) return;
+  HLSlab *s = hl->slabs;
+  while (s) {
+    HLSlab *nx = s->next;
+    free(s);
+    s = nx;
+  }
+  free(hl->table);
+  memset(hl, 0, sizeof(*hl));
+}
+
+/* Node of side 2^level whose top-left cell is (x, y) of g (dead outside g). */
+static HLNode *build(HashLife *hl, const Grid *g, int level, int64_t x, int64_t y) {
+  if (x >= g->w || y >= g->h) {
+    return empty_node(hl, level);
+  }
+  if (level == 0) {
+    return grid_row(g, (int)y)[x] ? &hl_alive : &hl_dead;
+  }
+  const int64_t half = (int64_t)1 << (level - 1);
+  HLNode *nw = build(hl, g, level - 1, x, y);
+  HLNode *ne = build(hl, g, level - 1, x + half, y);
+  HLNode *sw = build(hl, g, level - 1, x, y + half);
+  HLNode *se = build(hl, g, level - 1, x + half, y + half);
+  return join(hl, nw, ne, sw, se);
+}
+
+bool hashlife_load(HashLife *hl, const Grid *g) {
+  if (!hl || !hl->table || !g || !g->cells) {
+    return false;
+  }
+  int level = 3;
+  while (((int64_t)1 << level) < g->w || ((int64_t)1 << level) < g->h) {
+    level++;
+  }
+  HLNode *root = build(hl, g, level, 0, 0);
+  if (!root) {
+    return false;
+  }
+  hl->root = root;
+  hl->level = level;
+  hl->ox = 0;
+  hl->oy = 0;
+  hl->generation = 0;
+  collect(hl);
+  return true;
+}
+
+/* Node of level L+1 with n (level L >= 1) in its center, empty around. */
+static HLNode *embed(HashLife *hl, HLNode *n) {
+  HLNode *e = empty_node(hl, n->level - 1);
+  return join(hl, join(hl, e, e, e, n->nw), join(hl, e, e, n->ne, e),
+              join(hl, e, n->sw, e, e), join(hl, n->se, e, e, e));
+}
+
+/* Doubles the root's side, keeping the universe in place. */
+static bool expand(HashLife *hl) {
+  if (hl->level >= HL_MAX_LEVEL) {
+    hl->error = HASHLIFE_TOO_FAR;
+    return false;
+  }
+  HLNode *nr = embed(hl, hl->root);
+  if (!nr) {
+    hl->error = HASHLIFE_NO_MEMORY;
+    return false;
+  }
+  const int64_t shift = (int64_t)1 << (hl->level - 1);
+  hl->root = nr;
+  hl->level++;
+  hl->ox -= shift;
+  hl->oy -= shift;
+  return true;
+}
+
+/*
+ * True if every live cell lies in the central box of side 2^(L-2): rebuilding
+ * the root from that box alone gives the same (hash-consed) node. Needs L >= 3.
+ */
+static bool centred(HashLife *hl) {
+  HLNode *inner = centre(hl, centre(hl, hl->root));
+  HLNode *rebuilt = inner ? embed(hl, inner) : NULL;
+  rebuilt = rebuilt ? embed(hl, rebuilt) : NULL;
+  return rebuilt == hl->root;
+}
+
+bool hashlife_advance(HashLife *hl, uint64_t steps) {
+  if (!hl || !hl->root) {
+    return false;
+  }
+  hl->error = HASHLIFE_OK;
+  while (steps > 0) {
+    int j = 63;
+    while (!((steps >> j) & 1u)) {
+      j--;
+    }
+    if (j > hl->max_jump) {
+      j = hl->max_jump;
+    }
+
+    /*
+     * Live cells move at most one cell per generation: starting inside the
+     * central box (side/4) with 2^j <= side/8, they stay inside the returned half.
+     */
+    while (hl->level < j + 3 || !centred(hl)) {
+      if (!expand(hl)) {
+        return false;
+      }
+    }
+    HLNode *r = successor(hl, hl->root, j);
+    if (!r) {
+      hl->error = HASHLIFE_NO_MEMORY;
+      return false;
+    }
+    const int64_t shift = (int64_t)1 << (hl->level - 2);
+    hl->root = r;
+    hl->level--;
+    hl->ox += shift;
+    hl->oy += shift;
+    hl->generation += (uint64_t)1 << j;
+    steps -= (uint64_t)1 << j;
+
+    if (hashlife_mem_bytes(hl) > hl->mem_cap) {
+      collect(hl);
+      if (hashlife_mem_bytes(hl) > hl->mem_cap / 2u && hl->max_jump > 0) {
+        hl->max_jump--;
+      }
+    }
+  }
+  return true;
+}
+
+static void store_node(const HashLife *hl, const HLNode *n, int level, int64_t x, int64_t y, Grid *g) {
+  const int64_t size = (int64_t)1 << level;
+  if (x >= g->w || y >= g->h || x + size <= 0 || y + size <= 0) {
+    return;
+  }
+  if (n == hl->empty[level]) {
+    return;
+  }
+  if (level == 0) {
+    grid_row(g, (int)y)[x] = n->alive;
+    return;
+  }
+  const int64_t half = size / 2;
+  store_node(hl, n->nw, level - 1, x, y, g);
+  store_node(hl, n->ne, level - 1, x + half, y, g);
+  store_node(hl, n->sw, level - 1, x, y + half, g);
+  store_node(hl, n->se, level - 1, x + half, y + half, g);
+}
+
+bool hashlife_store(const HashLife *hl, Grid *g) {
+  if (!hl || !hl->root || !g || !g->cells) {
+    return false;
+  }
+  grid_clear(g);
+  store_node(hl, hl->root, hl->level, hl->ox, hl->oy, g);
+  return true;
+}
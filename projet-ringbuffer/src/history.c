@@ -1,133 +1,728 @@
 #include "history.h"
 
 #include <stdlib.h>
+#include <string.h>
+
+#include "delta.h"
+#include "life.h"
 
 static void history_zero(History *h) {
   if (!h) return;
-  h->buf = NULL;
+  h->mode = HISTORY_FULL;
+  h->slab = (GridSlab){0};
+  h->slots = NULL;
   h->cap = 0;
   h->start = 0;
   h->len = 0;
   h->cur = 0;
+  h->first_gen = 0;
+  h->reserved = false;
+  h->allocs = 0;
+  h->keyframe = 0;
+  h->deltas = NULL;
+  h->view = 0;
+  h->bits[0] = (BitGrid){0};
+  h->bits[1] = (BitGrid){0};
+  h->nwords = 0;
+  h->keys = NULL;
+  h->free_keys = NULL;
+  h->nfree = 0;
+  h->nkeys = 0;
+  h->enc = NULL;
+  h->nck = 0;
+  h->cached = false;
+  h->cache_seg = 0;
+  h->cache_hi = 0;
+  h->recomputed = 0;
+  h->log = NULL;
+  h->ring_lo = 0;
+  h->view_gen = SIZE_MAX;
+  h->mem = 0;
+  h->delta_bytes = 0;
+  h->peak_bytes = 0;
+}
+
+void history_options_default(HistoryOptions *o) {
+  if (!o) return;
+  o->mode = HISTORY_FULL;
+  o->keyframe = 0;
+  o->mem = 0;
+  o->path = NULL;
+  o->compress = false;
+}
+
+bool history_parse_mem(const char *s, size_t *out) {
+  char *end = NULL;
+  if (!s || !out) return false;
+  unsigned long long v = strtoull(s, &end, 10);
+  if (end == s || s[0] == '-') return false;
+  unsigned shift = 0;
+  switch (*end) {
+    case '\0': break;
+    case 'K': case 'k': shift = 10; end++; break;
+    case 'M': case 'm': shift = 20; end++; break;
+    case 'G': case 'g': shift = 30; end++; break;
+    case 'T': case 't': shift = 40; end++; break;
+    default: return false;
+  }
+  if (*end != '\0' || v == 0 || v > (unsigned long long)(SIZE_MAX >> shift)) return false;
+  *out = (size_t)v << shift;
+  return true;
+}
+
+int history_parse_arg(HistoryOptions *o, int argc, char **argv, int *i) {
+  if (!o || !argv || !i || *i >= argc) return 0;
+  const char *opt = argv[*i];
+  if (strcmp(opt, "--history-mode") == 0) {
+    if (*i + 1 >= argc) return -1;
+    const char *v = argv[++(*i)];
+    if (strcmp(v, "full") == 0) {
+      o->mode = HISTORY_FULL;
+    } else if (strcmp(v, "delta") == 0) {
+      o->mode = HISTORY_DELTA;
+    } else if (strcmp(v, "checkpoint") == 0) {
+      o->mode = HISTORY_CHECKPOINT;
+    } else if (strcmp(v, "disk") == 0) {
+      o->mode = HISTORY_DISK;
+    } else {
+      return -1;
+    }
+    return 1;
+  }
+  if (strcmp(opt, "--history-keyframe") == 0) {
+    if (*i + 1 >= argc) return -1;
+    char *end = NULL;
+    long v = strtol(argv[++(*i)], &end, 10);
+    if (end == argv[*i] || *end != '\0' || v < 1 || v > (1L << 20)) return -1;
+    o->keyframe = (int)v;
+    return 1;
+  }
+  if (strcmp(opt, "--history-mem") == 0) {
+    if (*i + 1 >= argc) return -1;
+    return history_parse_mem(argv[++(*i)], &o->mem) ? 1 : -1;
+  }
+  if (strcmp(opt, "--history-file") == 0) {
+    if (*i + 1 >= argc) return -1;
+    o->path = argv[++(*i)];
+    return 1;
+  }
+  if (strcmp(opt, "--history-compress") == 0) {
+    o->compress = true;
+    return 1;
+  }
+  return 0;
+}
+
+const char *history_usage(void) {
+  return "[--history-mode full|delta|checkpoint|disk] [--history-keyframe K] [--history-mem SIZE] "
+         "[--history-file PATH] [--history-compress]";
+}
+
+const char *history_mode_name(HistoryMode m) {
+  switch (m) {
+    case HISTORY_FULL: return "full";
+    case HISTORY_DELTA: return "delta";
+    case HISTORY_CHECKPOINT: return "checkpoint";
+    case HISTORY_DISK: return "disk";
+  }
+  return "?";
 }
 
+/* Full mode: the ring has cap + 1 physical slots. Delta mode: cap entries. */
 static size_t pos_phys(const History *h, size_t pos_rel) {
-  return (h->start + pos_rel) % h->cap;
+  const size_t n = (h->mode == HISTORY_FULL) ? h->cap + 1u : h->cap;
+  return (h->start + pos_rel) % n;
+}
+
+static uint64_t *key_bits(const History *h, int key) {
+  return h->keys + (size_t)key * h->nwords;
+}
+
+static HistoryDelta *delta_at(const History *h, size_t pos_rel) {
+  return &h->deltas[pos_phys(h, pos_rel)];
+}
+
+static void key_release(History *h, HistoryDelta *d) {
+  if (d->key >= 0) {
+    h->free_keys[h->nfree++] = d->key;
+    d->key = -1;
+  }
+}
+
+/* Stores bits as the keyframe of d. */
+static void key_store(History *h, HistoryDelta *d, const uint64_t *bits) {
+  if (d->key < 0) {
+    d->key = h->free_keys[--h->nfree];
+  }
+  memcpy(key_bits(h, d->key), bits, h->nwords * sizeof(uint64_t));
+}
+
+/* Checkpoint mode: grid of generation gen (a checkpoint, or cached). */
+static Grid *ck_checkpoint(const History *h, uint64_t gen) {
+  const uint64_t k = (uint64_t)h->keyframe;
+  const size_t seg = (size_t)(gen / k - h->first_gen / k);
+  return &h->slots[(h->start + seg) % h->nck];
+}
+
+static Grid *ck_cache(const History *h, uint64_t gen) {
+  return &h->slots[h->nck + (size_t)(gen % (uint64_t)h->keyframe) - 1u];
+}
+
+static Grid *ck_grid(const History *h, uint64_t gen) {
+  return (gen % (uint64_t)h->keyframe == 0) ? ck_checkpoint(h, gen) : ck_cache(h, gen);
+}
+
+/* Disk mode: generation gen is in the RAM ring. */
+static bool disk_hot(const History *h, size_t gen) {
+  return gen >= h->ring_lo && gen + h->cap >= h->len;
+}
+
+static Grid *disk_grid(const History *h, size_t gen) {
+  return disk_hot(h, gen) ? &h->slots[gen % (h->cap + 1u)] : &h->slots[h->cap + 1u];
+}
+
+/*
+ * Checkpoint mode: keyframe and capacity for a budget of grids buffers. cap
+ * generations span ceil(cap / K) + 1 checkpoints (with the one being
+ * written), and the cache K - 1 grids, so K fits if ceil(cap / K) + K <= grids.
+ * cap = 0 asks for the largest capacity.
+ */
+static void ck_plan(size_t grids, size_t *cap, int *keyframe) {
+  if (grids < 2) {
+    grids = 2;
+  }
+  for (size_t k = 1; *cap > 0 && k <= grids && k <= (size_t)(1 << 20); k++) {
+    if ((*cap + k - 1) / k + k <= grids) {
+      *keyframe = (int)k;
+      return;
+    }
+  }
+  /* Too many generations for the budget: keep what fits with K = grids / 2. */
+  size_t k = grids / 2u;
+  if (k > (size_t)(1 << 20)) {
+    k = (size_t)(1 << 20);
+  }
+  *keyframe = (int)k;
+  *cap = (grids - k) * k;
+}
+
+/*
+ * Capacity (0 => as many as fit) and keyframe interval for a budget of mem
+ * bytes. Full mode: one buffer per snapshot, plus the spare one. Disk mode:
+ * the same plus the view and a queue entry per buffer, after the log's work
+ * buffers (its index stays on disk). Checkpoint mode: ck_plan, or the
+ * capacity the given interval allows. Delta mode: the size of the deltas is
+ * only known as they come, so the fixed part (2 buffers, keyframe pool,
+ * entries) gets half of the budget and delta_commit evicts whenever the
+ * deltas overflow the rest. False if not even one snapshot fits.
+ */
+static bool history_plan(HistoryMode mode, const Grid *g, size_t mem, size_t *cap, int *keyframe) {
+  const size_t slot = grid_slab_slot_bytes(g->w, g->h, g->pad);
+  if (slot == 0) {
+    return false;
+  }
+  const size_t packed = ((size_t)g->w + 63u) / 64u * (size_t)g->h * sizeof(uint64_t);
+  const size_t grids = mem / (slot + sizeof(Grid));
+  size_t fit = 0;
+  if (mode == HISTORY_FULL) {
+    if (grids < 2) return false;
+    fit = grids - 1u;
+  } else if (mode == HISTORY_DISK) {
+    /* The log's work buffers, then per slot its queue entry (qcap = cap + 1). */
+    const size_t base = 3u * packed + delta_bound(packed / sizeof(uint64_t));
+    if (mem <= base) return false;
+    const size_t ring = (mem - base) / (slot + sizeof(Grid) + sizeof(Grid *));
+    if (ring < 3) return false;
+    fit = ring - 2u; /* the spare buffer and the view */
+  } else if (mode == HISTORY_CHECKPOINT) {
+    if (*keyframe <= 0) {
+      if (grids < 2) return false;
+      ck_plan(grids, cap, keyframe);
+      return true;
+    }
+    const size_t k = (size_t)*keyframe;
+    if (grids <= k) return false;
+    fit = (grids - k) * k;
+  } else {
+    if (*keyframe <= 0) {
+      *keyframe = 64;
+    }
+    const size_t key = packed + sizeof(int);
+    const size_t base = 2u * (slot + sizeof(Grid)) + 2u * packed + delta_bound(packed / sizeof(uint64_t)) + 2u * key;
+    const size_t per = sizeof(HistoryDelta) + key / (size_t)*keyframe + 1u;
+    if (mem / 2u <= base) return false;
+    fit = (mem / 2u - base) / per;
+    if (fit == 0) return false;
+  }
+  if (*cap == 0 || *cap > fit) {
+    *cap = fit;
+  }
+  return true;
 }
 
-static void free_slot(History *h, size_t pos_rel) {
-  if (!h || !h->buf || h->cap == 0) return;
-  size_t p = pos_phys(h, pos_rel);
-  if (h->buf[p]) {
-    grid_destroy(h->buf[p]);
-    h->buf[p] = NULL;
+static bool delta_init(History *h, const Grid *initial, int keyframe) {
+  h->keyframe = (keyframe > 0) ? keyframe : 64;
+  if (!bitgrid_create(&h->bits[0], initial->w, initial->h) || !bitgrid_create(&h->bits[1], initial->w, initial->h)) {
+    return false;
+  }
+  h->nwords = (size_t)h->bits[0].words * (size_t)initial->h;
+  /* The oldest snapshot, plus one per keyframe generation in a window of cap. */
+  const size_t nkeys = h->cap / (size_t)h->keyframe + 2u;
+  if (nkeys > (size_t)(1 << 30) || nkeys > SIZE_MAX / sizeof(uint64_t) / h->nwords) {
+    return false;
   }
+  h->nkeys = (int)nkeys;
+  h->deltas = (HistoryDelta *)calloc(h->cap, sizeof(HistoryDelta));
+  h->keys = (uint64_t *)malloc(nkeys * h->nwords * sizeof(uint64_t));
+  h->free_keys = (int *)malloc(nkeys * sizeof(int));
+  h->enc = (uint8_t *)malloc(delta_bound(h->nwords));
+  h->allocs += 6;
+  if (!h->deltas || !h->keys || !h->free_keys || !h->enc) {
+    return false;
+  }
+  for (size_t i = 0; i < h->cap; i++) {
+    h->deltas[i].key = -1;
+  }
+  for (int k = h->nkeys; k-- > 0;) {
+    h->free_keys[h->nfree++] = k;
+  }
+
+  h->view = 0;
+  (void)bitgrid_from_grid(&h->bits[0], initial);
+  key_store(h, &h->deltas[0], h->bits[0].bits);
+  return true;
 }
 
 bool history_init(History *h, const Grid *initial, size_t cap) {
+  return history_init_with(h, initial, cap, NULL);
+}
+
+bool history_init_with(History *h, const Grid *initial, size_t cap, const HistoryOptions *opt) {
   if (!h || !initial || !initial->cells) {
     return false;
   }
   history_zero(h);
 
-  if (cap == 0) {
+  h->mode = opt ? opt->mode : HISTORY_FULL;
+  h->mem = opt ? opt->mem : 0;
+  int keyframe = opt ? opt->keyframe : 0;
+  if (cap == 0 && h->mem == 0) {
     cap = 512;
   }
-
-  h->buf = (Grid **)calloc(cap, sizeof(Grid *));
-  if (!h->buf) {
-    history_zero(h);
+  size_t budget = h->mem;
+  if (h->mode == HISTORY_CHECKPOINT && budget == 0 && keyframe <= 0) {
+    budget = (size_t)1 << 30;
+  }
+  if (budget > 0 && !history_plan(h->mode, initial, budget, &cap, &keyframe)) {
+    return false;
+  }
+  if (cap == SIZE_MAX) {
     return false;
   }
+
+  size_t nslots = (h->mode == HISTORY_FULL) ? cap + 1u : 2u;
+  if (h->mode == HISTORY_DISK) {
+    nslots = cap + 2u;
+  }
+  if (h->mode == HISTORY_CHECKPOINT) {
+    h->keyframe = keyframe;
+    h->nck = (cap - 1u) / (size_t)keyframe + 2u;
+    nslots = h->nck + (size_t)keyframe - 1u;
+  }
   h->cap = cap;
-  h->start = 0;
-  h->len = 0;
-  h->cur = 0;
 
-  Grid *snap = grid_clone(initial);
-  if (!snap) {
-    free(h->buf);
+  h->slots = (Grid *)calloc(nslots, sizeof(Grid));
+  if (!h->slots) {
     history_zero(h);
     return false;
   }
-  h->buf[0] = snap;
+  if (!grid_slab_create(&h->slab, nslots, initial->w, initial->h, initial->pad)) {
+    free(h->slots);
+    history_zero(h);
+    return false;
+  }
+  for (size_t i = 0; i < nslots; i++) {
+    grid_slab_view(&h->slab, i, &h->slots[i]);
+  }
+  h->start = 0;
   h->len = 1;
   h->cur = 0;
+  h->allocs = 2;
+  (void)grid_copy(&h->slots[0], initial);
+
+  if (h->mode == HISTORY_DELTA && !delta_init(h, initial, keyframe)) {
+    history_free(h);
+    return false;
+  }
+  if (h->mode == HISTORY_DISK) {
+    const char *path = (opt->path && opt->path[0]) ? opt->path : "history.log";
+    h->log = (HistoryLog *)malloc(sizeof(HistoryLog));
+    h->allocs++;
+    if (!h->log || !history_log_open(h->log, path, initial->w, initial->h,
+                                     opt->compress ? HISTORY_LOG_COMPRESS : 0u, cap + 1u)) {
+      free(h->log);
+      h->log = NULL;
+      history_free(h);
+      return false;
+    }
+    (void)history_log_append(h->log, &h->slots[0]);
+  }
+  h->peak_bytes = history_bytes(h);
   return true;
 }
 
 void history_free(History *h) {
   if (!h) return;
-  if (h->buf && h->cap > 0) {
-    for (size_t rel = 0; rel < h->len; rel++) {
-      free_slot(h, rel);
+  if (h->log) {
+    history_log_close(h->log); /* writes what is queued: before the slab goes */
+    free(h->log);
+  }
+  grid_slab_free(&h->slab);
+  free(h->slots);
+  if (h->deltas) {
+    for (size_t i = 0; i < h->cap; i++) {
+      free(h->deltas[i].data);
     }
-    free(h->buf);
+    free(h->deltas);
   }
+  bitgrid_free(&h->bits[0]);
+  bitgrid_free(&h->bits[1]);
+  free(h->keys);
+  free(h->free_keys);
+  free(h->enc);
   history_zero(h);
 }
 
 Grid *history_current(History *h) {
-  if (!h || !h->buf || h->len == 0 || h->cap == 0) return NULL;
-  return h->buf[pos_phys(h, h->cur)];
+  if (!h || !h->slots || h->len == 0 || h->cap == 0) return NULL;
+  if (h->mode == HISTORY_DELTA) return &h->slots[h->view];
+  if (h->mode == HISTORY_CHECKPOINT) return ck_grid(h, h->first_gen + h->cur);
+  if (h->mode == HISTORY_DISK) return disk_grid(h, h->cur);
+  return &h->slots[pos_phys(h, h->cur)];
 }
 
 const Grid *history_current_const(const History *h) {
-  if (!h || !h->buf || h->len == 0 || h->cap == 0) return NULL;
-  return h->buf[pos_phys(h, h->cur)];
+  if (!h || !h->slots || h->len == 0 || h->cap == 0) return NULL;
+  if (h->mode == HISTORY_DELTA) return &h->slots[h->view];
+  if (h->mode == HISTORY_CHECKPOINT) return ck_grid(h, h->first_gen + h->cur);
+  if (h->mode == HISTORY_DISK) return disk_grid(h, h->cur);
+  return &h->slots[pos_phys(h, h->cur)];
 }
 
 void history_clear_forward(History *h) {
-  if (!h || !h->buf || h->len == 0) return;
+  if (!h || !h->slots || h->len == 0) return;
   if (h->cur + 1 >= h->len) return;
-
-  for (size_t rel = h->cur + 1; rel < h->len; rel++) {
-    free_slot(h, rel);
+  if (h->mode == HISTORY_DELTA) {
+    for (size_t rel = h->cur + 1; rel < h->len; rel++) {
+      key_release(h, delta_at(h, rel));
+    }
+  }
+  if (h->mode == HISTORY_DISK) {
+    /* The ring keeps what it holds, the window of the old end, up to cur. */
+    if (!disk_hot(h, h->cur)) {
+      h->ring_lo = h->cur + 1u; /* cur is in the view */
+    } else if (h->len > h->cap && h->ring_lo < h->len - h->cap) {
+      h->ring_lo = h->len - h->cap;
+    }
+    if (h->view_gen != SIZE_MAX && h->view_gen > h->cur) {
+      h->view_gen = SIZE_MAX;
+    }
+    (void)history_log_truncate(h->log, h->cur + 1u);
+  }
+  const uint64_t gen = h->first_gen + h->cur;
+  if (h->mode == HISTORY_CHECKPOINT && h->cached && h->cache_hi > gen) {
+    /* The cache may hold the dropped generations, or be past them. */
+    if (h->cache_seg > gen / (uint64_t)h->keyframe) {
+      h->cached = false;
+    } else {
+      h->cache_hi = gen;
+    }
   }
   h->len = h->cur + 1;
 }
 
-bool history_push(History *h, const Grid *g) {
-  if (!h || !h->buf || h->cap == 0 || h->len == 0 || !g || !g->cells) {
-    return false;
+/*
+ * Checkpoint mode: a checkpoint goes to the next ring slot, first dropping the
+ * oldest checkpoint and its span when the ring is full. Another generation
+ * goes to the cache, which then holds the current checkpoint's span.
+ */
+static Grid *ck_reserve(History *h) {
+  const uint64_t k = (uint64_t)h->keyframe;
+  const uint64_t gen = h->first_gen + h->len;
+  if (gen % k != 0) {
+    if (!h->cached || h->cache_seg != gen / k) {
+      h->cached = true;
+      h->cache_seg = gen / k;
+      h->cache_hi = gen - 1u;
+    }
+    return ck_cache(h, gen);
+  }
+  if (gen / k - h->first_gen / k == h->nck) {
+    h->start = (h->start + 1) % h->nck;
+    h->first_gen += k;
+    h->len -= (size_t)k;
+    h->cur -= (size_t)k;
+    if (h->cached && h->cache_seg < h->first_gen / k) {
+      h->cached = false;
+    }
   }
+  return ck_checkpoint(h, gen);
+}
 
+Grid *history_reserve(History *h) {
+  if (!h || !h->slots || h->cap == 0 || h->len == 0) {
+    return NULL;
+  }
   if (h->cur != (h->len - 1)) {
     history_clear_forward(h);
   }
+  h->reserved = true;
+  if (h->mode == HISTORY_DELTA) {
+    return &h->slots[h->view ^ 1];
+  }
+  if (h->mode == HISTORY_CHECKPOINT) {
+    return ck_reserve(h);
+  }
+  if (h->mode == HISTORY_DISK) {
+    /* The slot last held generation len - cap - 1: it must be on disk. */
+    if (!history_log_wait(h->log, (h->len > h->cap) ? h->len - h->cap : 0)) {
+      h->reserved = false;
+      return NULL;
+    }
+    return &h->slots[h->len % (h->cap + 1u)];
+  }
+  /* len <= cap < cap + 1: the slot after the logical end holds no snapshot. */
+  return &h->slots[pos_phys(h, h->len)];
+}
 
-  Grid *snap = grid_clone(g);
-  if (!snap) {
-    return false;
+/* Delta mode: drops the oldest snapshot; its keyframe moves to the next one. */
+static void delta_evict(History *h) {
+  HistoryDelta *old = delta_at(h, 0);
+  if (h->len > 1) {
+    HistoryDelta *next = delta_at(h, 1);
+    if (next->key < 0) {
+      next->key = old->key;
+      old->key = -1;
+      (void)delta_apply(next->data, next->size, key_bits(h, next->key), h->nwords, NULL, 0);
+    }
+  }
+  key_release(h, old);
+  h->start = (h->start + 1) % h->cap;
+  h->first_gen++;
+  h->len--;
+}
+
+static bool delta_commit(History *h) {
+  Grid *next = &h->slots[h->view ^ 1];
+  (void)bitgrid_from_grid(&h->bits[1], next);
+  const size_t size = delta_encode(h->bits[0].bits, h->bits[1].bits, h->nwords, h->enc);
+
+  if (h->len == h->cap) {
+    delta_evict(h);
+  }
+  HistoryDelta *d = delta_at(h, h->len);
+  if (size > d->room) {
+    const size_t room = size + size / 2u;
+    uint8_t *data = (uint8_t *)realloc(d->data, room);
+    if (!data) {
+      return false;
+    }
+    h->delta_bytes += room - d->room;
+    d->data = data;
+    d->room = room;
+    h->allocs++;
+  }
+  if (size > 0) {
+    memcpy(d->data, h->enc, size); /* identical generations: empty delta, data may be NULL */
   }
+  d->size = size;
+  if (h->len == 0 || (h->first_gen + h->len) % (uint64_t)h->keyframe == 0) {
+    key_store(h, d, h->bits[1].bits);
+  }
+
+  h->len++;
+  h->cur = h->len - 1;
+  BitGrid tmp = h->bits[0];
+  h->bits[0] = h->bits[1];
+  h->bits[1] = tmp;
+  h->view ^= 1;
 
-  if (h->len < h->cap) {
-    size_t phys = pos_phys(h, h->len);
-    h->buf[phys] = snap;
+  /* Over budget: drop the oldest generations, and their buffers. */
+  while (h->mem > 0 && h->len > 1 && history_bytes(h) > h->mem) {
+    HistoryDelta *old = delta_at(h, 0);
+    delta_evict(h);
+    h->delta_bytes -= old->room;
+    free(old->data);
+    old->data = NULL;
+    old->size = 0;
+    old->room = 0;
+    h->cur--;
+  }
+  return true;
+}
+
+bool history_commit(History *h) {
+  if (!h || !h->reserved) {
+    return false;
+  }
+  h->reserved = false;
+  if (h->mode == HISTORY_DELTA) {
+    const bool ok = delta_commit(h);
+    const size_t bytes = history_bytes(h);
+    if (bytes > h->peak_bytes) {
+      h->peak_bytes = bytes;
+    }
+    return ok;
+  }
+  if (h->mode == HISTORY_CHECKPOINT) {
     h->len++;
     h->cur = h->len - 1;
+    if ((h->first_gen + h->cur) % (uint64_t)h->keyframe != 0) {
+      h->cache_hi = h->first_gen + h->cur;
+    }
     return true;
   }
-
-  /* Full buffer: evict the oldest snapshot (rel=0) */
-  if (h->len == h->cap) {
-    /* physical index of the oldest == start */
-    if (h->buf[h->start]) {
-      grid_destroy(h->buf[h->start]);
-      h->buf[h->start] = NULL;
+  if (h->mode == HISTORY_DISK) {
+    if (!history_log_append(h->log, &h->slots[h->len % (h->cap + 1u)])) {
+      return false;
     }
-    h->start = (h->start + 1) % h->cap;
-
-    /* write at the logical end (rel = len-1) */
-    size_t phys_end = pos_phys(h, h->len - 1);
-    h->buf[phys_end] = snap;
+    h->len++;
     h->cur = h->len - 1;
+    const size_t bytes = history_bytes(h);
+    if (bytes > h->peak_bytes) {
+      h->peak_bytes = bytes;
+    }
     return true;
   }
+  if (h->len == h->cap) {
+    /* Full buffer: evict the oldest snapshot (rel=0). */
+    h->start = (h->start + 1) % (h->cap + 1u);
+    h->first_gen++;
+  } else {
+    h->len++;
+  }
+  h->cur = h->len - 1;
+  return true;
+}
+
+static bool same_cells(const Grid *a, const Grid *b) {
+  for (int y = 0; y < a->h; y++) {
+    if (memcmp(grid_row(a, y), grid_row(b, y), (size_t)a->w) != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool history_push(History *h, const Grid *g) {
+  if (!h || !g || !g->cells || g->w != h->slab.w || g->h != h->slab.h) {
+    return false;
+  }
+  Grid *next = history_reserve(h);
+  if (!next) {
+    return false;
+  }
+  if (h->mode == HISTORY_CHECKPOINT && (h->first_gen + h->len) % (uint64_t)h->keyframe != 0) {
+    /* Between two checkpoints only life_step's result can be recomputed. */
+    life_step(history_current_const(h), next);
+    if (!same_cells(next, g)) {
+      h->reserved = false;
+      return false;
+    }
+    return history_commit(h);
+  }
+  if (!grid_copy(next, g)) {
+    return false;
+  }
+  return history_commit(h);
+}
+
+/*
+ * Delta mode: makes the view hold snapshot rel, walking the deltas from the
+ * current snapshot or from the closest keyframe at or before rel.
+ */
+static void delta_goto(History *h, size_t rel) {
+  Grid *view = &h->slots[h->view];
+  size_t key = rel;
+  while (delta_at(h, key)->key < 0) {
+    key--; /* the oldest snapshot holds a keyframe */
+  }
+  const size_t walk = (rel > h->cur) ? rel - h->cur : h->cur - rel;
+  size_t at = h->cur;
+  if (rel - key < walk) {
+    memcpy(h->bits[0].bits, key_bits(h, delta_at(h, key)->key), h->nwords * sizeof(uint64_t));
+    (void)bitgrid_to_grid(&h->bits[0], view);
+    at = key;
+  }
+  for (; at < rel; at++) {
+    const HistoryDelta *d = delta_at(h, at + 1);
+    (void)delta_apply(d->data, d->size, h->bits[0].bits, h->nwords, view, h->bits[0].words);
+  }
+  for (; at > rel; at--) {
+    const HistoryDelta *d = delta_at(h, at);
+    (void)delta_apply(d->data, d->size, h->bits[0].bits, h->nwords, view, h->bits[0].words);
+  }
+  life_refresh_halo(view);
+  h->cur = rel;
+}
+
+/*
+ * Checkpoint mode: makes generation rel available, recomputing the span from
+ * its checkpoint (or from the last cached generation) if needed.
+ */
+static void ck_goto(History *h, size_t rel) {
+  const uint64_t k = (uint64_t)h->keyframe;
+  const uint64_t gen = h->first_gen + rel;
+  if (gen % k != 0) {
+    if (!h->cached || h->cache_seg != gen / k) {
+      h->cached = true;
+      h->cache_seg = gen / k;
+      h->cache_hi = gen - gen % k;
+    }
+    for (; h->cache_hi < gen; h->cache_hi++) {
+      life_step(ck_grid(h, h->cache_hi), ck_cache(h, h->cache_hi + 1u));
+      h->recomputed++;
+    }
+  }
+  h->cur = rel;
+}
+
+/* Disk mode: makes generation gen current, reading it from the log if it left the ring. */
+static bool disk_goto(History *h, size_t gen) {
+  if (!disk_hot(h, gen) && h->view_gen != gen) {
+    Grid *view = &h->slots[h->cap + 1u];
+    h->view_gen = SIZE_MAX;
+    if (!history_log_wait(h->log, gen + 1u) || !history_log_read(h->log, gen, view)) {
+      return false;
+    }
+    life_refresh_halo(view);
+    h->view_gen = gen;
+  }
+  h->cur = gen;
+  return true;
+}
 
-  /* unreachable */
-  grid_destroy(snap);
-  return false;
+size_t history_bytes(const History *h) {
+  if (!h || !h->slots) return 0;
+  size_t bytes = h->slab.bytes + h->slab.count * sizeof(Grid);
+  if (h->mode == HISTORY_DELTA) {
+    bytes += h->cap * sizeof(HistoryDelta) + 2u * h->nwords * sizeof(uint64_t);
+    bytes += (size_t)h->nkeys * (h->nwords * sizeof(uint64_t) + sizeof(int)) + delta_bound(h->nwords);
+    bytes += h->delta_bytes;
+  }
+  if (h->mode == HISTORY_DISK && h->log) {
+    const size_t packed = h->log->nwords * sizeof(uint64_t);
+    bytes += h->log->qcap * sizeof(Grid *) + 3u * packed + delta_bound(h->log->nwords);
+  }
+  return bytes;
+}
+
+uint64_t history_disk_bytes(const History *h) {
+  return (h && h->log) ? history_log_bytes(h->log) : 0;
+}
+
+size_t history_peak_bytes(const History *h) {
+  return h ? h->peak_bytes : 0;
 }
 
 bool history_can_back(const History *h) {
@@ -140,12 +735,69 @@ bool history_can_forward(const History *h) {
 
 bool history_back(History *h) {
   if (!history_can_back(h)) return false;
+  if (h->mode == HISTORY_DELTA) {
+    delta_goto(h, h->cur - 1);
+    return true;
+  }
+  if (h->mode == HISTORY_CHECKPOINT) {
+    ck_goto(h, h->cur - 1);
+    return true;
+  }
+  if (h->mode == HISTORY_DISK) {
+    return disk_goto(h, h->cur - 1);
+  }
   h->cur--;
   return true;
 }
 
 bool history_forward(History *h) {
   if (!history_can_forward(h)) return false;
+  if (h->mode == HISTORY_DELTA) {
+    delta_goto(h, h->cur + 1);
+    return true;
+  }
+  if (h->mode == HISTORY_CHECKPOINT) {
+    ck_goto(h, h->cur + 1);
+    return true;
+  }
+  if (h->mode == HISTORY_DISK) {
+    return disk_goto(h, h->cur + 1);
+  }
   h->cur++;
   return true;
 }
+
+uint64_t history_generation(const History *h) {
+  return (h && h->len > 0) ? h->first_gen + h->cur : 0;
+}
+
+uint64_t history_first_generation(const History *h) {
+  return h ? h->first_gen : 0;
+}
+
+uint64_t history_last_generation(const History *h) {
+  return (h && h->len > 0) ? h->first_gen + h->len - 1u : 0;
+}
+
+bool history_seek(History *h, uint64_t gen) {
+  if (!h || h->len == 0 || gen < h->first_gen || gen - h->first_gen >= h->len) {
+    return false;
+  }
+  const size_t rel = (size_t)(gen - h->first_gen);
+  if (rel == h->cur) {
+    return true;
+  }
+  if (h->mode == HISTORY_DELTA) {
+    delta_goto(h, rel);
+    return true;
+  }
+  if (h->mode == HISTORY_CHECKPOINT) {
+    ck_goto(h, rel);
+    return true;
+  }
+  if (h->mode == HISTORY_DISK) {
+    return disk_goto(h, rel);
+  }
+  h->cur = rel;
+  return true;
+}
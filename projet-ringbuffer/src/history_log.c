@@ -0,0 +1,373 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "history_log.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "delta.h"
+
+enum { LOG_HEADER = 64 };
+
+struct HistoryLogSync {
+  pthread_t writer;
+  bool started;
+  pthread_mutex_t lock;
+  pthread_cond_t work; /* a record was queued, or quit */
+  pthread_cond_t done; /* a record was written */
+  const Grid **queue;  /* record i waits in queue[i % qcap] */
+  uint64_t queued;
+  uint64_t written;
+  uint64_t end;        /* end offset of the last written record (the index itself stays on disk) */
+  bool quit;
+  bool error;
+  /* Writer only. */
+  BitGrid bits;
+  uint64_t *zero;      /* compression reference: the empty grid */
+  uint8_t *enc;
+  /* Caller only. */
+  uint8_t *map;        /* read-only mapping of the first map_len bytes of PATH */
+  size_t map_len;
+};
+
+static bool write_all(int fd, const void *data, size_t size, uint64_t off) {
+  const uint8_t *p = (const uint8_t *)data;
+  while (size > 0) {
+    const ssize_t n = pwrite(fd, p, size, (off_t)off);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      return false;
+    }
+    p += n;
+    size -= (size_t)n;
+    off += (uint64_t)n;
+  }
+  return true;
+}
+
+static bool read_all(int fd, void *data, size_t size, uint64_t off) {
+  uint8_t *p = (uint8_t *)data;
+  while (size > 0) {
+    const ssize_t n = pread(fd, p, size, (off_t)off);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      return false;
+    }
+    p += n;
+    size -= (size_t)n;
+    off += (uint64_t)n;
+  }
+  return true;
+}
+
+/* End offset of record i (written), from PATH.idx. */
+static bool record_end(const HistoryLog *log, uint64_t i, uint64_t *end) {
+  return read_all(log->idx_fd, end, sizeof(*end), i * sizeof(*end));
+}
+
+static void *log_writer(void *arg) {
+  HistoryLog *log = (HistoryLog *)arg;
+  struct HistoryLogSync *s = log->sync;
+  const size_t raw = log->nwords * sizeof(uint64_t);
+
+  (void)pthread_mutex_lock(&s->lock);
+  for (;;) {
+    while (s->written == s->queued && !s->quit) {
+      (void)pthread_cond_wait(&s->work, &s->lock);
+    }
+    if (s->written == s->queued) {
+      break;
+    }
+    const uint64_t i = s->written;
+    const Grid *g = s->queue[i % log->qcap];
+    const uint64_t off = s->end;
+    bool ok = !s->error;
+    (void)pthread_mutex_unlock(&s->lock);
+
+    uint64_t end = off;
+    if (ok) {
+      (void)bitgrid_from_grid(&s->bits, g);
+      const void *data = s->bits.bits;
+      size_t size = raw;
+      if (log->flags & HISTORY_LOG_COMPRESS) {
+        size = delta_encode(s->zero, s->bits.bits, log->nwords, s->enc);
+        data = s->enc;
+      }
+      end = off + size;
+      ok = write_all(log->fd, data, size, off) && write_all(log->idx_fd, &end, sizeof(end), i * sizeof(end));
+    }
+
+    (void)pthread_mutex_lock(&s->lock);
+    if (ok) {
+      s->end = end;
+    } else {
+      s->error = true;
+    }
+    s->written++;
+    (void)pthread_cond_broadcast(&s->done);
+  }
+  (void)pthread_mutex_unlock(&s->lock);
+  return NULL;
+}
+
+static void unmap(struct HistoryLogSync *s) {
+  if (s->map) {
+    (void)munmap(s->map, s->map_len);
+  }
+  s->map = NULL;
+  s->map_len = 0;
+}
+
+bool history_log_open(HistoryLog *log, const char *path, int w, int h, unsigned flags, size_t qcap) {
+  if (!log || !path || qcap == 0) {
+    return false;
+  }
+  *log = (HistoryLog){0};
+  log->fd = -1;
+  log->idx_fd = -1;
+  log->w = w;
+  log->h = h;
+  log->flags = flags;
+  log->qcap = qcap;
+
+  struct HistoryLogSync *s = (struct HistoryLogSync *)calloc(1, sizeof(*s));
+  if (!s) {
+    return false;
+  }
+  log->sync = s;
+  (void)pthread_mutex_init(&s->lock, NULL);
+  (void)pthread_cond_init(&s->work, NULL);
+  (void)pthread_cond_init(&s->done, NULL);
+  s->end = LOG_HEADER;
+  if (!bitgrid_create(&s->bits, w, h) || !bitgrid_create(&log->read_bits, w, h)) {
+    history_log_close(log);
+    return false;
+  }
+  log->nwords = (size_t)s->bits.words * (size_t)h;
+  s->queue = (const Grid **)calloc(qcap, sizeof(const Grid *));
+  s->zero = (uint64_t *)calloc(log->nwords, sizeof(uint64_t));
+  s->enc = (uint8_t *)malloc(delta_bound(log->nwords));
+  if (!s->queue || !s->zero || !s->enc) {
+    history_log_close(log);
+    return false;
+  }
+
+  /*
+   * Written under temporary names, then renamed over PATH.idx and PATH: a log
+   * still open on them (the history being replaced) keeps writing to its own
+   * files, now unlinked. The old index waits under PATH.idx.old until PATH is
+   * replaced, so a failed open leaves both old files in place.
+   */
+  char idx_path[4096], tmp_path[4096], tmp_idx_path[4096], old_idx_path[4096];
+  if (snprintf(idx_path, sizeof(idx_path), "%s.idx", path) >= (int)sizeof(idx_path) ||
+      snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path) >= (int)sizeof(tmp_path) ||
+      snprintf(tmp_idx_path, sizeof(tmp_idx_path), "%s.idx.tmp", path) >= (int)sizeof(tmp_idx_path) ||
+      snprintf(old_idx_path, sizeof(old_idx_path), "%s.idx.old", path) >= (int)sizeof(old_idx_path)) {
+    history_log_close(log);
+    return false;
+  }
+  log->fd = open(tmp_path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+  log->idx_fd = open(tmp_idx_path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+
+  uint8_t header[LOG_HEADER] = {0};
+  const uint32_t fields[4] = {(uint32_t)w, (uint32_t)h, (uint32_t)flags, (uint32_t)s->bits.words};
+  memcpy(header, "GOLHLOG1", 8);
+  memcpy(header + 8, fields, sizeof(fields));
+  if (log->fd < 0 || log->idx_fd < 0 || !write_all(log->fd, header, sizeof(header), 0) ||
+      pthread_create(&s->writer, NULL, log_writer, log) != 0) {
+    (void)unlink(tmp_path);
+    (void)unlink(tmp_idx_path);
+    history_log_close(log);
+    return false;
+  }
+  s->started = true;
+
+  const bool had_idx = (rename(idx_path, old_idx_path) == 0);
+  const bool idx_moved = (had_idx || errno == ENOENT) && rename(tmp_idx_path, idx_path) == 0;
+  if (!idx_moved || rename(tmp_path, path) != 0) {
+    if (had_idx) {
+      (void)rename(old_idx_path, idx_path); /* replaces ours if it was moved in */
+    } else if (idx_moved) {
+      (void)unlink(idx_path);
+    }
+    (void)unlink(tmp_path);
+    (void)unlink(tmp_idx_path);
+    history_log_close(log);
+    return false;
+  }
+  if (had_idx) {
+    (void)unlink(old_idx_path);
+  }
+  return true;
+}
+
+void history_log_close(HistoryLog *log) {
+  if (!log) {
+    return;
+  }
+  struct HistoryLogSync *s = log->sync;
+  if (s) {
+    if (s->started) {
+      (void)pthread_mutex_lock(&s->lock);
+      s->quit = true;
+      (void)pthread_cond_signal(&s->work);
+      (void)pthread_mutex_unlock(&s->lock);
+      (void)pthread_join(s->writer, NULL);
+    }
+    unmap(s);
+    bitgrid_free(&s->bits);
+    free(s->queue);
+    free(s->zero);
+    free(s->enc);
+    (void)pthread_mutex_destroy(&s->lock);
+    (void)pthread_cond_destroy(&s->work);
+    (void)pthread_cond_destroy(&s->done);
+    free(s);
+  }
+  if (log->fd >= 0) {
+    (void)close(log->fd);
+  }
+  if (log->idx_fd >= 0) {
+    (void)close(log->idx_fd);
+  }
+  bitgrid_free(&log->read_bits);
+  *log = (HistoryLog){0};
+  log->fd = -1;
+  log->idx_fd = -1;
+}
+
+bool history_log_append(HistoryLog *log, const Grid *g) {
+  if (!log || !log->sync || !g || g->w != log->w || g->h != log->h) {
+    return false;
+  }
+  struct HistoryLogSync *s = log->sync;
+  (void)pthread_mutex_lock(&s->lock);
+  while (s->queued - s->written >= log->qcap) {
+    (void)pthread_cond_wait(&s->done, &s->lock);
+  }
+  const bool ok = !s->error;
+  if (ok) {
+    s->queue[s->queued % log->qcap] = g;
+    s->queued++;
+    (void)pthread_cond_signal(&s->work);
+  }
+  (void)pthread_mutex_unlock(&s->lock);
+  return ok;
+}
+
+bool history_log_wait(HistoryLog *log, uint64_t count) {
+  if (!log || !log->sync) {
+    return false;
+  }
+  struct HistoryLogSync *s = log->sync;
+  (void)pthread_mutex_lock(&s->lock);
+  while (s->written < count && s->written < s->queued) {
+    (void)pthread_cond_wait(&s->done, &s->lock);
+  }
+  const bool ok = !s->error && s->written >= count;
+  (void)pthread_mutex_unlock(&s->lock);
+  return ok;
+}
+
+bool history_log_truncate(HistoryLog *log, uint64_t count) {
+  if (!log || !log->sync) {
+    return false;
+  }
+  struct HistoryLogSync *s = log->sync;
+  (void)pthread_mutex_lock(&s->lock);
+  while (s->written < s->queued) {
+    (void)pthread_cond_wait(&s->done, &s->lock);
+  }
+  bool ok = !s->error;
+  if (ok && count < s->written) {
+    uint64_t end = LOG_HEADER;
+    ok = (count == 0 || record_end(log, count - 1u, &end));
+    if (ok) {
+      s->written = count;
+      s->queued = count;
+      s->end = end;
+    }
+  }
+  const uint64_t len = s->end;
+  (void)pthread_mutex_unlock(&s->lock);
+
+  if (s->map_len > len) {
+    unmap(s); /* pages past the end of the file would fault */
+  }
+  return ok && ftruncate(log->fd, (off_t)len) == 0 &&
+         ftruncate(log->idx_fd, (off_t)(count * sizeof(uint64_t))) == 0;
+}
+
+bool history_log_read(HistoryLog *log, uint64_t i, Grid *g) {
+  if (!log || !log->sync || !g || g->w != log->w || g->h != log->h) {
+    return false;
+  }
+  struct HistoryLogSync *s = log->sync;
+  (void)pthread_mutex_lock(&s->lock);
+  const bool ok = !s->error && i < s->written;
+  const uint64_t len = s->end;
+  (void)pthread_mutex_unlock(&s->lock);
+  /* Entries of written records no longer change: read them unlocked. */
+  uint64_t off = LOG_HEADER, end = 0;
+  if (!ok || (i > 0 && !record_end(log, i - 1u, &off)) || !record_end(log, i, &end) || off > end || end > len) {
+    return false;
+  }
+
+  if (s->map_len < end) {
+    /* Map everything written so far: later reads of older records are free. */
+    unmap(s);
+    void *map = mmap(NULL, (size_t)len, PROT_READ, MAP_SHARED, log->fd, 0);
+    if (map == MAP_FAILED) {
+      return false;
+    }
+    s->map = (uint8_t *)map;
+    s->map_len = (size_t)len;
+  }
+
+  const uint8_t *data = s->map + off;
+  const size_t size = (size_t)(end - off);
+  if (log->flags & HISTORY_LOG_COMPRESS) {
+    memset(log->read_bits.bits, 0, log->nwords * sizeof(uint64_t));
+    if (!delta_apply(data, size, log->read_bits.bits, log->nwords, NULL, 0)) {
+      return false;
+    }
+  } else {
+    if (size != log->nwords * sizeof(uint64_t)) {
+      return false;
+    }
+    memcpy(log->read_bits.bits, data, size);
+  }
+  return bitgrid_to_grid(&log->read_bits, g);
+}
+
+uint64_t history_log_count(const HistoryLog *log) {
+  if (!log || !log->sync) {
+    return 0;
+  }
+  struct HistoryLogSync *s = log->sync;
+  (void)pthread_mutex_lock(&s->lock);
+  const uint64_t n = s->queued;
+  (void)pthread_mutex_unlock(&s->lock);
+  return n;
+}
+
+uint64_t history_log_bytes(const HistoryLog *log) {
+  if (!log || !log->sync) {
+    return 0;
+  }
+  struct HistoryLogSync *s = log->sync;
+  (void)pthread_mutex_lock(&s->lock);
+  const uint64_t n = s->end;
+  (void)pthread_mutex_unlock(&s->lock);
+  return n;
+}
@@ -20,6 +20,10 @@ static void set_errf(char *err, size_t cap, const char *fmt, const char *detail)
 }
 
 bool grid_load_from_file(const char *path, Grid *out, char *err, size_t errcap) {
+  return grid_load_with_rule(path, out, NULL, err, errcap);
+}
+
+bool grid_load_with_rule(const char *path, Grid *out, LifeRule *rule, char *err, size_t errcap) {
   if (!path || !out) {
     set_err(err, errcap, "Paramètres invalides");
     return false;
@@ -39,9 +43,17 @@ bool grid_load_from_file(const char *path, Grid *out, char *err, size_t errcap)
   }
 
   int w = 0, h = 0;
-  if (sscanf(header, "%d %d", &w, &h) != 2 || w <= 0 || h <= 0) {
+  char rule_tok[32];
+  int fields = sscanf(header, "%d %d %31s", &w, &h, rule_tok);
+  if (fields < 2 || w <= 0 || h <= 0) {
+    fclose(f);
+    set_err(err, errcap, "En-tête invalide (attendu: width height [règle])");
+    return false;
+  }
+  LifeRule file_rule = life_rule_conway();
+  if (fields == 3 && !life_parse_rule(rule_tok, &file_rule)) {
     fclose(f);
-    set_err(err, errcap, "En-tête invalide (attendu: width height)");
+    set_err(err, errcap, "Règle invalide dans l'en-tête (attendu: B3/S23)");
     return false;
   }
 
@@ -113,6 +125,9 @@ bool grid_load_from_file(const char *path, Grid *out, char *err, size_t errcap)
 
   grid_free(out);
   *out = tmp;
+  if (rule && fields == 3) {
+    *rule = file_rule;
+  }
   return true;
 }
 
@@ -128,7 +143,9 @@ bool grid_save_to_file(const char *path, const Grid *g, char *err, size_t errcap
     return false;
   }
 
-  if (fprintf(f, "%d %d\n", g->w, g->h) < 0) {
+  char rule[24];
+  life_rule_format(life_rule(), rule, sizeof(rule));
+  if (fprintf(f, "%d %d %s\n", g->w, g->h, rule) < 0) {
     fclose(f);
     set_err(err, errcap, "Erreur d'écriture (header)");
     return false;
@@ -1,6 +1,38 @@
 #include "life.h"
 
+#include <ctype.h>
 #include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "life_simd.h"
+
+typedef int (*LifeRowFn)(const uint8_t *up, const uint8_t *mid, const uint8_t *down,
+                         uint8_t *out, int w);
+
+typedef int (*LifeRuleRowFn)(const uint8_t *up, const uint8_t *mid, const uint8_t *down,
+                             uint8_t *out, int w, const LifeRuleLut *lut);
+
+typedef uint8_t (*LifeCellFn)(const Grid *cur, int x, int y);
+
+static LifeKernel g_kernel = LIFE_KERNEL_AUTO;
+static LifeBoundary g_boundary = LIFE_BOUNDARY_DEAD;
+static LifeRule g_rule = {{0, 0, 0, 1, 0, 0, 0, 0, 0}, {0, 0, 1, 1, 0, 0, 0, 0, 0}};
+static bool g_conway = true;
+static LifeRuleLut g_lut = {{0, 0, 0, 1}, {0, 0, 1, 1}};
+
+/*
+ * LUT kernel: bit 4*c + r of the index is the cell at column c, row r of a 4x4
+ * neighborhood; bit 2*y + x of the entry is the next state of its center cell
+ * (x + 1, y + 1). Built for the active rule when the kernel is selected.
+ */
+static uint8_t g_block_lut[1u << 16];
+static bool g_block_lut_ready = false;
+
+/* Next state of a cell from the rule table. */
+static inline uint8_t rule_next(uint8_t alive, int n) {
+  return alive ? g_rule.survive[n] : g_rule.birth[n];
+}
 
 int count_neighbors(const Grid *g, int x, int y) {
   int n = 0;
@@ -15,25 +47,434 @@ int count_neighbors(const Grid *g, int x, int y) {
   return n;
 }
 
+static uint8_t cell_next(const Grid *cur, int x, int y) {
+  return rule_next(grid_get(cur, x, y), count_neighbors(cur, x, y));
+}
+
+/* Same as cell_next with wrapped coordinates (grids without halo). */
+static uint8_t cell_next_torus(const Grid *cur, int x, int y) {
+  const int w = cur->w;
+  const int h = cur->h;
+  const int xs[3] = {(x == 0) ? w - 1 : x - 1, x, (x + 1 == w) ? 0 : x + 1};
+  const int ys[3] = {(y == 0) ? h - 1 : y - 1, y, (y + 1 == h) ? 0 : y + 1};
+  int n = 0;
+  for (int j = 0; j < 3; j++) {
+    const uint8_t *row = grid_row(cur, ys[j]);
+    for (int i = 0; i < 3; i++) {
+      n += row[xs[i]];
+    }
+  }
+  uint8_t alive = grid_row(cur, y)[x];
+  return rule_next(alive, n - alive);
+}
+
+static void block_lut_build(void) {
+  for (unsigned idx = 0; idx < (1u << 16); idx++) {
+    uint8_t v = 0;
+    for (int y = 0; y < 2; y++) {
+      for (int x = 0; x < 2; x++) {
+        int n = 0;
+        for (int dr = 0; dr < 3; dr++) {
+          for (int dc = 0; dc < 3; dc++) {
+            n += (int)((idx >> (4 * (x + dc) + (y + dr))) & 1u);
+          }
+        }
+        const uint8_t alive = (uint8_t)((idx >> (4 * (x + 1) + (y + 1))) & 1u);
+        v |= (uint8_t)(rule_next(alive, n - alive) << (2 * y + x));
+      }
+    }
+    g_block_lut[idx] = v;
+  }
+  g_block_lut_ready = true;
+}
+
+static bool kernel_supported(LifeKernel k, const LifeCpu *cpu) {
+  switch (k) {
+    case LIFE_KERNEL_SCALAR: return true;
+    case LIFE_KERNEL_LUT: return true;
+    case LIFE_KERNEL_SSE2: return cpu->sse2;
+    case LIFE_KERNEL_AVX2: return cpu->avx2;
+    case LIFE_KERNEL_AVX512: return cpu->avx512bw;
+    case LIFE_KERNEL_AUTO: return true;
+  }
+  return false;
+}
+
+bool life_set_kernel(LifeKernel k) {
+  LifeCpu cpu;
+  life_cpu_detect(&cpu);
+  if (k == LIFE_KERNEL_AUTO) {
+    if (cpu.avx512bw) {
+      k = LIFE_KERNEL_AVX512;
+    } else if (cpu.avx2) {
+      k = LIFE_KERNEL_AVX2;
+    } else if (cpu.sse2) {
+      k = LIFE_KERNEL_SSE2;
+    } else {
+      k = LIFE_KERNEL_SCALAR;
+    }
+  }
+  if (!kernel_supported(k, &cpu)) {
+    return false;
+  }
+  if (k == LIFE_KERNEL_LUT && !g_block_lut_ready) {
+    block_lut_build();
+  }
+  g_kernel = k;
+  return true;
+}
+
+LifeKernel life_active_kernel(void) {
+  if (g_kernel == LIFE_KERNEL_AUTO) {
+    (void)life_set_kernel(LIFE_KERNEL_AUTO);
+  }
+  return g_kernel;
+}
+
+const char *life_kernel_name(LifeKernel k) {
+  switch (k) {
+    case LIFE_KERNEL_AUTO: return "auto";
+    case LIFE_KERNEL_SCALAR: return "scalar";
+    case LIFE_KERNEL_SSE2: return "sse2";
+    case LIFE_KERNEL_AVX2: return "avx2";
+    case LIFE_KERNEL_AVX512: return "avx512";
+    case LIFE_KERNEL_LUT: return "lut";
+  }
+  return "?";
+}
+
+bool life_parse_kernel(const char *s, LifeKernel *out) {
+  if (!s || !out) return false;
+  static const LifeKernel all[] = {LIFE_KERNEL_AUTO, LIFE_KERNEL_SCALAR, LIFE_KERNEL_SSE2,
+                                   LIFE_KERNEL_AVX2, LIFE_KERNEL_AVX512, LIFE_KERNEL_LUT};
+  for (size_t i = 0; i < sizeof(all) / sizeof(all[0]); i++) {
+    if (strcmp(s, life_kernel_name(all[i])) == 0) {
+      *out = all[i];
+      return true;
+    }
+  }
+  return false;
+}
+
+bool life_set_boundary(LifeBoundary b) {
+  if (b != LIFE_BOUNDARY_DEAD && b != LIFE_BOUNDARY_TORUS) {
+    return false;
+  }
+  g_boundary = b;
+  return true;
+}
+
+LifeBoundary life_boundary(void) {
+  return g_boundary;
+}
+
+const char *life_boundary_name(LifeBoundary b) {
+  switch (b) {
+    case LIFE_BOUNDARY_DEAD: return "dead";
+    case LIFE_BOUNDARY_TORUS: return "torus";
+  }
+  return "?";
+}
+
+bool life_parse_boundary(const char *s, LifeBoundary *out) {
+  if (!s || !out) return false;
+  if (strcmp(s, "dead") == 0) {
+    *out = LIFE_BOUNDARY_DEAD;
+  } else if (strcmp(s, "torus") == 0) {
+    *out = LIFE_BOUNDARY_TORUS;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+LifeRule life_rule_conway(void) {
+  LifeRule r = {{0, 0, 0, 1, 0, 0, 0, 0, 0}, {0, 0, 1, 1, 0, 0, 0, 0, 0}};
+  return r;
+}
+
+bool life_rule_is_conway(const LifeRule *r) {
+  LifeRule c = life_rule_conway();
+  return r && memcmp(r, &c, sizeof(c)) == 0;
+}
+
+bool life_set_rule(const LifeRule *r) {
+  if (!r || r->birth[0]) {
+    return false;
+  }
+  g_rule = *r;
+  g_conway = life_rule_is_conway(r);
+  memset(&g_lut, 0, sizeof(g_lut));
+  memcpy(g_lut.birth, r->birth, sizeof(r->birth));
+  memcpy(g_lut.survive, r->survive, sizeof(r->survive));
+  if (g_kernel == LIFE_KERNEL_LUT) {
+    block_lut_build();
+  } else {
+    g_block_lut_ready = false;
+  }
+  return true;
+}
+
+const LifeRule *life_rule(void) {
+  return &g_rule;
+}
+
+bool life_parse_rule(const char *s, LifeRule *out) {
+  if (!s || !out) return false;
+  LifeRule r;
+  memset(&r, 0, sizeof(r));
+  bool seen_b = false, seen_s = false;
+  for (int part = 0; part < 2; part++) {
+    char c = (char)toupper((unsigned char)*s++);
+    uint8_t *t = NULL;
+    if (c == 'B' && !seen_b) {
+      t = r.birth;
+      seen_b = true;
+    } else if (c == 'S' && !seen_s) {
+      t = r.survive;
+      seen_s = true;
+    } else {
+      return false;
+    }
+    while (*s >= '0' && *s <= '8') {
+      t[*s - '0'] = 1u;
+      s++;
+    }
+    if (part == 0) {
+      if (*s != '/') return false;
+      s++;
+    }
+  }
+  if (*s != '\0' || r.birth[0]) {
+    return false;
+  }
+  *out = r;
+  return true;
+}
+
+void life_rule_format(const LifeRule *r, char *buf, size_t cap) {
+  if (!buf || cap == 0) return;
+  char tmp[24];
+  size_t k = 0;
+  tmp[k++] = 'B';
+  for (int n = 0; n <= 8; n++) {
+    if (r && r->birth[n]) tmp[k++] = (char)('0' + n);
+  }
+  tmp[k++] = '/';
+  tmp[k++] = 'S';
+  for (int n = 0; n <= 8; n++) {
+    if (r && r->survive[n]) tmp[k++] = (char)('0' + n);
+  }
+  tmp[k] = '\0';
+  (void)snprintf(buf, cap, "%s", tmp);
+}
+
+void life_refresh_halo(Grid *g) {
+  if (g_boundary == LIFE_BOUNDARY_TORUS) {
+    grid_wrap_halo(g);
+  } else {
+    grid_clear_halo(g);
+  }
+}
+
+static LifeRowFn row_fn(LifeKernel k) {
+  switch (k) {
+    case LIFE_KERNEL_SSE2: return life_row_sse2;
+    case LIFE_KERNEL_AVX2: return life_row_avx2;
+    case LIFE_KERNEL_AVX512: return life_row_avx512;
+    default: return NULL;
+  }
+}
+
+static LifeRuleRowFn rule_row_fn(LifeKernel k) {
+  switch (k) {
+    case LIFE_KERNEL_SSE2: return life_row_rule_sse2;
+    case LIFE_KERNEL_AVX2: return life_row_rule_avx2;
+    case LIFE_KERNEL_AVX512: return life_row_rule_avx512;
+    default: return NULL;
+  }
+}
+
+/*
+ * Vector interior of one row with the active rule (see LifeRowFn), or 1 when
+ * no vector kernel is selected. B3/S23 keeps its specialized kernels.
+ */
+static inline int row_vec(LifeRowFn vec, LifeRuleRowFn rvec, const uint8_t *up, const uint8_t *mid,
+                          const uint8_t *down, uint8_t *out, int w) {
+  if (vec) {
+    return vec(up, mid, down, out, w);
+  }
+  if (rvec) {
+    return rvec(up, mid, down, out, w, &g_lut);
+  }
+  return 1;
+}
+
 void life_step(const Grid *cur, Grid *next) {
+  if (!cur || !next || !next->cells || cur->w != next->w || cur->h != next->h) {
+    return;
+  }
+  life_step_rows(cur, next, 0, cur->h);
+  if (g_boundary == LIFE_BOUNDARY_TORUS) {
+    grid_wrap_halo(next);
+  }
+}
+
+/* Next state of cell x of row mid, reading the neighbors through the halo (no bounds checks). */
+static inline uint8_t cell_next_halo(const uint8_t *up, const uint8_t *mid, const uint8_t *down, int x) {
+  int n = up[x - 1] + up[x] + up[x + 1] + mid[x - 1] + mid[x + 1] + down[x - 1] + down[x] + down[x + 1];
+  return (uint8_t)((n == 3) | ((n == 2) & mid[x]));
+}
+
+/* Same as cell_next_halo with the rule table. */
+static inline uint8_t cell_next_halo_rule(const uint8_t *up, const uint8_t *mid, const uint8_t *down, int x) {
+  int n = up[x - 1] + up[x] + up[x + 1] + mid[x - 1] + mid[x + 1] + down[x - 1] + down[x] + down[x + 1];
+  return rule_next(mid[x], n);
+}
+
+static inline uint8_t halo_cell(const uint8_t *up, const uint8_t *mid, const uint8_t *down, int x) {
+  return g_conway ? cell_next_halo(up, mid, down, x) : cell_next_halo_rule(up, mid, down, x);
+}
+
+enum { LUT_SEGMENT = 256 };
+
+/* cols[i] = cells (x + i) of rows r0..r3 in bits 0..3 (cells are 0/1: 8 columns per word). */
+static inline void lut_columns(const uint8_t *r0, const uint8_t *r1, const uint8_t *r2, const uint8_t *r3,
+                               int x, int count, uint8_t *cols) {
+  int i = 0;
+  for (; i + 8 <= count; i += 8) {
+    uint64_t a, b, c, d;
+    memcpy(&a, r0 + x + i, sizeof(a));
+    memcpy(&b, r1 + x + i, sizeof(b));
+    memcpy(&c, r2 + x + i, sizeof(c));
+    memcpy(&d, r3 + x + i, sizeof(d));
+    const uint64_t v = a | (b << 1) | (c << 2) | (d << 3);
+    memcpy(cols + i, &v, sizeof(v));
+  }
+  for (; i < count; i++) {
+    cols[i] = (uint8_t)(r0[x + i] | (r1[x + i] << 1) | (r2[x + i] << 2) | (r3[x + i] << 3));
+  }
+}
+
+/*
+ * LUT kernel on [x0, x1) x [y0, y1) of a grid with a halo: each 2x2 block is one
+ * lookup of its 4x4 neighborhood. An odd last row or column is stepped per cell,
+ * so nothing outside the rectangle is written.
+ */
+static void step_rect_lut(const Grid *cur, Grid *next, int x0, int y0, int x1, int y1) {
+  const ptrdiff_t stride = cur->stride;
+  uint8_t cols[LUT_SEGMENT + 2];
+  int y = y0;
+  for (; y + 1 < y1; y += 2) {
+    const uint8_t *r1 = grid_row(cur, y);
+    const uint8_t *r0 = r1 - stride;
+    const uint8_t *r2 = r1 + stride;
+    const uint8_t *r3 = r2 + stride;
+    uint8_t *o0 = grid_row(next, y);
+    uint8_t *o1 = grid_row(next, y + 1);
+    int x = x0;
+    while (x1 - x >= 2) {
+      int seg = (x1 - x) & ~1;
+      if (seg > LUT_SEGMENT) seg = LUT_SEGMENT;
+      /* Columns x-1 .. x+seg: the 4x4 window of block i starts at cols[i]. */
+      lut_columns(r0, r1, r2, r3, x - 1, seg + 2, cols);
+      unsigned idx = (unsigned)cols[0] << 8 | (unsigned)cols[1] << 12;
+      for (int i = 0; i < seg; i += 2) {
+        idx = (idx >> 8) | (unsigned)cols[i + 2] << 8 | (unsigned)cols[i + 3] << 12;
+        const uint8_t v = g_block_lut[idx];
+        o0[x + i] = v & 1u;
+        o0[x + i + 1] = (v >> 1) & 1u;
+        o1[x + i] = (v >> 2) & 1u;
+        o1[x + i + 1] = v >> 3;
+      }
+      x += seg;
+    }
+    if (x < x1) {
+      o0[x] = halo_cell(r0, r1, r2, x);
+      o1[x] = halo_cell(r1, r2, r3, x);
+    }
+  }
+  if (y < y1) {
+    const uint8_t *mid = grid_row(cur, y);
+    uint8_t *out = grid_row(next, y);
+    for (int x = x0; x < x1; x++) {
+      out[x] = halo_cell(mid - stride, mid, mid + stride, x);
+    }
+  }
+}
+
+void life_step_rows(const Grid *cur, Grid *next, int y0, int y1) {
+  if (!cur || !cur->cells) {
+    return;
+  }
+  life_step_rect(cur, next, 0, y0, cur->w, y1);
+}
+
+void life_step_rect(const Grid *cur, Grid *next, int x0, int y0, int x1, int y1) {
   if (!cur || !next || !cur->cells || !next->cells) {
     return;
   }
   if (cur->w != next->w || cur->h != next->h) {
     return;
   }
+  if (x0 < 0) x0 = 0;
+  if (y0 < 0) y0 = 0;
+  if (x1 > cur->w) x1 = cur->w;
+  if (y1 > cur->h) y1 = cur->h;
+  if (x0 >= x1) {
+    return;
+  }
+
+  const int w = cur->w;
+  const ptrdiff_t stride = cur->stride;
+  const LifeKernel kernel = life_active_kernel();
+  LifeRowFn vec = g_conway ? row_fn(kernel) : NULL;
+  LifeRuleRowFn rvec = g_conway ? NULL : rule_row_fn(kernel);
 
-  for (int y = 0; y < cur->h; y++) {
-    for (int x = 0; x < cur->w; x++) {
-      uint8_t alive = grid_get(cur, x, y);
-      int n = count_neighbors(cur, x, y);
-      uint8_t out = 0;
-      if (alive) {
-        out = (n == 2 || n == 3) ? 1u : 0u;
+  if (kernel == LIFE_KERNEL_LUT && cur->pad >= 1 && g_block_lut_ready) {
+    step_rect_lut(cur, next, x0, y0, x1, y1);
+    return;
+  }
+
+  /* Halo: every row and column has readable neighbors (dead or wrapped). */
+  if (cur->pad >= 1) {
+    for (int y = y0; y < y1; y++) {
+      const uint8_t *mid = grid_row(cur, y) + x0;
+      uint8_t *out = grid_row(next, y) + x0;
+      const int n = x1 - x0;
+      /* Shifted by one so the vector interior [1, n+1) covers columns [x0, x1). */
+      int x = row_vec(vec, rvec, mid - stride - 1, mid - 1, mid + stride - 1, out - 1, n + 2) - 1;
+      if (g_conway) {
+        for (; x < n; x++) {
+          out[x] = cell_next_halo(mid - stride, mid, mid + stride, x);
+        }
       } else {
-        out = (n == 3) ? 1u : 0u;
+        for (; x < n; x++) {
+          out[x] = cell_next_halo_rule(mid - stride, mid, mid + stride, x);
+        }
       }
-      next->cells[(size_t)y * (size_t)cur->w + (size_t)x] = out;
+    }
+    return;
+  }
+
+  /* No halo: bounds-checked (or wrapped) cells on the borders. */
+  LifeCellFn cell = (g_boundary == LIFE_BOUNDARY_TORUS) ? cell_next_torus : cell_next;
+  /* Vector interior: columns [xs, xe) of the rows with both neighbors, within 1..w-2. */
+  const int xs = (x0 > 1) ? x0 : 1;
+  const int xe = (x1 < w - 1) ? x1 : w - 1;
+  for (int y = y0; y < y1; y++) {
+    uint8_t *out = grid_row(next, y);
+    int x = x0;
+    if ((vec || rvec) && y > 0 && y + 1 < cur->h && xe > xs) {
+      const uint8_t *mid = grid_row(cur, y);
+      for (; x < xs; x++) {
+        out[x] = cell(cur, x, y);
+      }
+      x = xs - 1 + row_vec(vec, rvec, mid - stride + xs - 1, mid + xs - 1, mid + stride + xs - 1,
+                           out + xs - 1, xe - xs + 2);
+    }
+    for (; x < x1; x++) {
+      out[x] = cell(cur, x, y);
     }
   }
 }
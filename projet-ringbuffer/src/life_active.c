@@ -0,0 +1,208 @@
+#include "life_active.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "life.h"
+
+/*
+ * Task width in cells: a row of tiles is split into spans of about this many
+ * cells (whole tiles), long enough for the row sweeps to stay vectorized.
+ */
+enum { ACTIVE_TASK_CELLS = 1024 };
+
+typedef struct ActiveJob {
+  LifeActive *a;
+  const Grid *cur;
+  Grid *next;
+  bool next_is_prev;
+  int span;  /* tiles per task */
+  int spans; /* tasks per row of tiles */
+} ActiveJob;
+
+bool life_active_init(LifeActive *a, int w, int h, int tile) {
+  if (!a || w <= 0 || h <= 0 || tile < 1) {
+    return false;
+  }
+  memset(a, 0, sizeof(*a));
+  a->tile = tile;
+  a->tiles_x = (w + tile - 1) / tile;
+  a->tiles_y = (h + tile - 1) / tile;
+
+  size_t n = (size_t)a->tiles_x * (size_t)a->tiles_y;
+  a->changed = (uint8_t *)malloc(n);
+  a->next_changed = (uint8_t *)malloc(n);
+  a->active = (uint8_t *)malloc(n);
+  if (!a->changed || !a->next_changed || !a->active) {
+    life_active_free(a);
+    return false;
+  }
+  life_active_reset(a);
+  return true;
+}
+
+void life_active_free(LifeActive *a) {
+  if (!a) return;
+  free(a->changed);
+  free(a->next_changed);
+  free(a->active);
+  memset(a, 0, sizeof(*a));
+}
+
+void life_active_reset(LifeActive *a) {
+  if (!a || !a->changed) return;
+  memset(a->changed, 1, (size_t)a->tiles_x * (size_t)a->tiles_y);
+}
+
+/*
+ * A tile is active if a tile of its 3x3 neighborhood changed (wrapped on the torus):
+ * every changed tile switches on its neighborhood, so sparse grids cost little.
+ */
+static uint64_t mark_active(LifeActive *a, bool torus) {
+  const int tx_n = a->tiles_x;
+  const int ty_n = a->tiles_y;
+  const size_t total = (size_t)tx_n * (size_t)ty_n;
+  uint64_t on = 0;
+  memset(a->active, 0, total);
+  for (size_t t = 0; t < total; t++) {
+    if (!a->changed[t]) {
+      continue;
+    }
+    const int tx = (int)(t % (size_t)tx_n);
+    const int ty = (int)(t / (size_t)tx_n);
+    for (int dy = -1; dy <= 1; dy++) {
+      int y = ty + dy;
+      if (y < 0 || y >= ty_n) {
+        if (!torus) continue;
+        y = (y + ty_n) % ty_n;
+      }
+      uint8_t *row = a->active + (size_t)y * (size_t)tx_n;
+      for (int dx = -1; dx <= 1; dx++) {
+        int x = tx + dx;
+        if (x < 0 || x >= tx_n) {
+          if (!torus) continue;
+          x = (x + tx_n) % tx_n;
+        }
+        on += (row[x] == 0);
+        row[x] = 1;
+      }
+    }
+  }
+  return (uint64_t)total - on;
+}
+
+/* Records in changed[] which tiles [tx0, tx1) of the row band [y0, y1) differ between cur and next. */
+static void detect_changes(const LifeActive *a, const Grid *cur, const Grid *next,
+                           const uint8_t *active, uint8_t *changed, int tx0, int tx1, int y0, int y1) {
+  for (int t = tx0; t < tx1; t++) {
+    if (!active[t]) {
+      continue;
+    }
+    const int x0 = t * a->tile;
+    const size_t n = (size_t)((x0 + a->tile < cur->w) ? a->tile : cur->w - x0);
+    for (int y = y0; y < y1; y++) {
+      if (memcmp(grid_row(next, y) + x0, grid_row(cur, y) + x0, n) != 0) {
+        changed[t] = 1;
+        break;
+      }
+    }
+  }
+}
+
+/*
+ * Steps the active tiles [tx0, tx1) of tile row ty row by row, runs of
+ * consecutive active tiles as one span, so that busy regions are swept in long
+ * sequential rows.
+ */
+static void active_span(ActiveJob *job, int ty, int tx0, int tx1) {
+  LifeActive *a = job->a;
+  const Grid *cur = job->cur;
+  Grid *next = job->next;
+  const int tile = a->tile;
+  const uint8_t *active = a->active + (size_t)ty * (size_t)a->tiles_x;
+  uint8_t *changed = a->next_changed + (size_t)ty * (size_t)a->tiles_x;
+  const int y0 = ty * tile;
+  const int y1 = (y0 + tile < cur->h) ? y0 + tile : cur->h;
+  const int cx0 = tx0 * tile;
+  const int cx1 = (tx1 * tile < cur->w) ? tx1 * tile : cur->w;
+  memset(changed + tx0, 0, (size_t)(tx1 - tx0));
+
+  if (memchr(active + tx0, 0, (size_t)(tx1 - tx0)) == NULL) {
+    /* Fully active span: plain row sweep. */
+    life_step_rect(cur, next, cx0, y0, cx1, y1);
+    detect_changes(a, cur, next, active, changed, tx0, tx1, y0, y1);
+    return;
+  }
+  if (job->next_is_prev && memchr(active + tx0, 1, (size_t)(tx1 - tx0)) == NULL) {
+    return;
+  }
+
+  for (int y = y0; y < y1; y++) {
+    int tx = tx0;
+    while (tx < tx1) {
+      /* Run [tx, end) of tiles sharing the same activity. */
+      const void *stop = memchr(active + tx, !active[tx], (size_t)(tx1 - tx));
+      const int end = stop ? (int)((const uint8_t *)stop - active) : tx1;
+      const int x0 = tx * tile;
+      const int x1 = (end * tile < cur->w) ? end * tile : cur->w;
+      if (active[tx]) {
+        life_step_rect(cur, next, x0, y, x1, y + 1);
+      } else if (!job->next_is_prev) {
+        /* Still neighborhood: the tiles are unchanged (and so were they in next's generation). */
+        memcpy(grid_row(next, y) + x0, grid_row(cur, y) + x0, (size_t)(x1 - x0));
+      }
+      tx = end;
+    }
+  }
+  detect_changes(a, cur, next, active, changed, tx0, tx1, y0, y1);
+}
+
+/* Task t: span t % spans of tile row t / spans. */
+static void active_task(void *ctx, int task, int worker) {
+  (void)worker;
+  ActiveJob *job = (ActiveJob *)ctx;
+  const int ty = task / job->spans;
+  const int tx0 = (task % job->spans) * job->span;
+  const int tx1 = (tx0 + job->span < job->a->tiles_x) ? tx0 + job->span : job->a->tiles_x;
+  active_span(job, ty, tx0, tx1);
+}
+
+bool life_active_step(LifeActive *a, LifePool *pool, const Grid *cur, Grid *next, bool next_is_prev) {
+  if (!a || !a->changed || !cur || !next || !cur->cells || !next->cells) {
+    return false;
+  }
+  if (cur->w != next->w || cur->h != next->h) {
+    return false;
+  }
+  if ((cur->w + a->tile - 1) / a->tile != a->tiles_x || (cur->h + a->tile - 1) / a->tile != a->tiles_y) {
+    return false;
+  }
+
+  const uint64_t skipped = mark_active(a, life_boundary() == LIFE_BOUNDARY_TORUS);
+  a->tiles_skipped += skipped;
+  a->tiles_stepped += (uint64_t)a->tiles_x * (uint64_t)a->tiles_y - skipped;
+
+  const int span = (a->tile < ACTIVE_TASK_CELLS) ? ACTIVE_TASK_CELLS / a->tile : 1;
+  ActiveJob job = {a, cur, next, next_is_prev, span, (a->tiles_x + span - 1) / span};
+  const int ntasks = job.spans * a->tiles_y;
+  if (pool) {
+    /* Per-tile cost ranges from nothing to a full step: tasks are balanced by work stealing. */
+    life_pool_run_tasks(pool, active_task, &job, ntasks);
+  } else {
+    for (int t = 0; t < ntasks; t++) {
+      active_task(&job, t, 0);
+    }
+  }
+
+  uint8_t *tmp = a->changed;
+  a->changed = a->next_changed;
+  a->next_changed = tmp;
+  life_refresh_halo(next);
+  return true;
+}
+
+double life_active_skipped_ratio(const LifeActive *a) {
+  if (!a) return 0.0;
+  uint64_t total = a->tiles_stepped + a->tiles_skipped;
+  return (total == 0) ? 0.0 : (double)a->tiles_skipped / (double)total;
+}
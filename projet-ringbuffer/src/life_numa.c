@@ -0,0 +1,108 @@
+#define _GNU_SOURCE
+
+#include "life_numa.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static LifeNumaTopology g_topo;
+static pthread_once_t g_topo_once = PTHREAD_ONCE_INIT;
+
+/* Adds the allowed CPUs of a "0-3,8,10-11" list to the current last node. */
+static void add_cpu_list(LifeNumaTopology *t, const char *list, const cpu_set_t *allowed) {
+  const int node = t->nnodes - 1;
+  const char *p = list;
+  while (*p) {
+    char *end = NULL;
+    long lo = strtol(p, &end, 10);
+    if (end == p) {
+      break;
+    }
+    long hi = lo;
+    p = end;
+    if (*p == '-') {
+      hi = strtol(p + 1, &end, 10);
+      p = end;
+    }
+    for (long c = lo; c <= hi; c++) {
+      const int used = t->first_cpu[node] + t->ncpus[node];
+      if (c >= 0 && c < CPU_SETSIZE && CPU_ISSET((int)c, allowed) && used < LIFE_NUMA_MAX_CPUS) {
+        t->cpus[used] = (int)c;
+        t->ncpus[node]++;
+      }
+    }
+    if (*p == ',') {
+      p++;
+    } else {
+      break;
+    }
+  }
+}
+
+static void topology_read(void) {
+  LifeNumaTopology *t = &g_topo;
+  cpu_set_t allowed;
+  CPU_ZERO(&allowed);
+  if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+    CPU_SET(0, &allowed);
+  }
+
+  t->nnodes = 0;
+  int used = 0;
+  for (int id = 0; id < 1024 && t->nnodes < LIFE_NUMA_MAX_NODES; id++) {
+    char path[96];
+    char list[4096];
+    (void)snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", id);
+    FILE *f = fopen(path, "r");
+    if (!f) {
+      continue;
+    }
+    const bool ok = (fgets(list, sizeof(list), f) != NULL);
+    fclose(f);
+    if (!ok) {
+      continue;
+    }
+    t->node_id[t->nnodes] = id;
+    t->first_cpu[t->nnodes] = used;
+    t->ncpus[t->nnodes] = 0;
+    t->nnodes++;
+    add_cpu_list(t, list, &allowed);
+    if (t->ncpus[t->nnodes - 1] == 0) {
+      t->nnodes--; /* memory-only node, or none of its CPUs allowed */
+    } else {
+      used += t->ncpus[t->nnodes - 1];
+    }
+  }
+
+  if (t->nnodes == 0) {
+    t->nnodes = 1;
+    t->node_id[0] = 0;
+    t->first_cpu[0] = 0;
+    t->ncpus[0] = 0;
+    for (int c = 0; c < CPU_SETSIZE && t->ncpus[0] < LIFE_NUMA_MAX_CPUS; c++) {
+      if (CPU_ISSET(c, &allowed)) {
+        t->cpus[t->ncpus[0]++] = c;
+      }
+    }
+    if (t->ncpus[0] == 0) {
+      t->cpus[t->ncpus[0]++] = 0;
+    }
+  }
+}
+
+const LifeNumaTopology *life_numa_topology(void) {
+  (void)pthread_once(&g_topo_once, topology_read);
+  return &g_topo;
+}
+
+bool life_numa_pin_self(int cpu) {
+  if (cpu < 0 || cpu >= CPU_SETSIZE) {
+    return false;
+  }
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  return sched_setaffinity(0, sizeof(set), &set) == 0;
+}
@@ -0,0 +1,490 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "life_pool.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "life.h"
+#include "life_numa.h"
+
+typedef struct LifePoolWorker {
+  LifePool *pool;
+  int index;
+} LifePoolWorker;
+
+/*
+ * Chase-Lev deque over a range of task numbers. Every task is pushed before the
+ * job starts, so only the two ends move: the owner pops at the bottom, thieves
+ * take at the top with a CAS. Slot j holds task mirror - j, so the owner runs
+ * its range in increasing order and thieves take it from the far end.
+ */
+typedef struct TaskDeque {
+  atomic_int top;
+  atomic_int bottom;
+  int mirror;
+  char pad[64 - 3 * sizeof(int)]; /* one deque per cache line */
+} TaskDeque;
+
+enum { DEQUE_EMPTY = -1, DEQUE_RETRY = -2 };
+
+struct LifePoolSync {
+  pthread_t *threads;
+  LifePoolWorker *workers;
+  pthread_barrier_t start;
+  pthread_barrier_t done;
+  pthread_mutex_t gate_lock; /* startup gate: workers wait until every thread exists */
+  pthread_cond_t gate_cv;
+  int gate;                  /* 0 = pending, 1 = go, -1 = abort */
+  TaskDeque *deques;         /* one per thread (task jobs) */
+};
+
+typedef struct StepJob {
+  const Grid *cur;
+  Grid *next;
+} StepJob;
+
+static void band_rows(const LifePool *p, int index, int *y0, int *y1) {
+  long rows = p->rows;
+  *y0 = (int)(rows * index / p->nthreads);
+  *y1 = (int)(rows * (index + 1) / p->nthreads);
+}
+
+static uint64_t now_ns(void) {
+  struct timespec ts;
+  (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/* Owner side: next slot of d, or DEQUE_EMPTY. */
+static int deque_pop(TaskDeque *d) {
+  const int b = atomic_load_explicit(&d->bottom, memory_order_relaxed) - 1;
+  atomic_store_explicit(&d->bottom, b, memory_order_relaxed);
+  atomic_thread_fence(memory_order_seq_cst);
+  int t = atomic_load_explicit(&d->top, memory_order_relaxed);
+  if (t > b) {
+    atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+    return DEQUE_EMPTY;
+  }
+  if (t == b) {
+    /* Last slot: race the thieves for it. */
+    const bool won = atomic_compare_exchange_strong_explicit(&d->top, &t, t + 1, memory_order_seq_cst,
+                                                             memory_order_relaxed);
+    atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+    return won ? b : DEQUE_EMPTY;
+  }
+  return b;
+}
+
+/* Thief side: oldest slot of d, DEQUE_EMPTY, or DEQUE_RETRY if another thread won it. */
+static int deque_steal(TaskDeque *d) {
+  int t = atomic_load_explicit(&d->top, memory_order_acquire);
+  atomic_thread_fence(memory_order_seq_cst);
+  const int b = atomic_load_explicit(&d->bottom, memory_order_acquire);
+  if (t >= b) {
+    return DEQUE_EMPTY;
+  }
+  if (!atomic_compare_exchange_strong_explicit(&d->top, &t, t + 1, memory_order_seq_cst,
+                                               memory_order_relaxed)) {
+    return DEQUE_RETRY;
+  }
+  return t;
+}
+
+/* Runs the own deque, then (STEAL) takes tasks from the others until all are empty. */
+static void run_tasks(LifePool *p, int index) {
+  TaskDeque *deques = p->sync->deques;
+  TaskDeque *own = &deques[index];
+  for (int slot = deque_pop(own); slot >= 0; slot = deque_pop(own)) {
+    p->task_fn(p->ctx, own->mirror - slot, index);
+  }
+  if (p->schedule != LIFE_SCHEDULE_STEAL) {
+    return;
+  }
+  /* No task is ever added: once every deque looks empty, the job is done here. */
+  for (;;) {
+    bool contended = false;
+    bool stolen = false;
+    for (int k = 1; k < p->nthreads && !stolen; k++) {
+      TaskDeque *victim = &deques[(index + k) % p->nthreads];
+      const int slot = deque_steal(victim);
+      if (slot >= 0) {
+        p->task_fn(p->ctx, victim->mirror - slot, index);
+        stolen = true;
+      } else if (slot == DEQUE_RETRY) {
+        contended = true;
+      }
+    }
+    if (!stolen && !contended) {
+      break;
+    }
+  }
+}
+
+static void run_band(LifePool *p, int index) {
+  const uint64_t t0 = now_ns();
+  if (p->task_fn) {
+    run_tasks(p, index);
+  } else {
+    int y0 = 0, y1 = 0;
+    band_rows(p, index, &y0, &y1);
+    if (y0 < y1) {
+      p->fn(p->ctx, y0, y1);
+    }
+  }
+  p->busy_ns[index] += now_ns() - t0;
+}
+
+/* Band rows of index for the current band job (rows counter). */
+static void count_rows(LifePool *p, int index) {
+  if (!p->task_fn) {
+    int y0 = 0, y1 = 0;
+    band_rows(p, index, &y0, &y1);
+    p->rows_done[index] += (uint64_t)(y1 - y0);
+  }
+}
+
+static void *worker_main(void *arg) {
+  LifePoolWorker *wk = (LifePoolWorker *)arg;
+  LifePool *p = wk->pool;
+  struct LifePoolSync *s = p->sync;
+
+  (void)pthread_mutex_lock(&s->gate_lock);
+  while (s->gate == 0) {
+    (void)pthread_cond_wait(&s->gate_cv, &s->gate_lock);
+  }
+  int gate = s->gate;
+  (void)pthread_mutex_unlock(&s->gate_lock);
+  if (gate < 0) {
+    return NULL;
+  }
+
+  for (;;) {
+    (void)pthread_barrier_wait(&s->start);
+    if (p->quit) {
+      break;
+    }
+    run_band(p, wk->index);
+    count_rows(p, wk->index);
+    (void)pthread_barrier_wait(&s->done);
+  }
+  return NULL;
+}
+
+static void pool_zero(LifePool *p) {
+  p->nthreads = 1;
+  p->sync = NULL;
+  p->fn = NULL;
+  p->task_fn = NULL;
+  p->ctx = NULL;
+  p->rows = 0;
+  p->quit = false;
+  p->schedule = LIFE_SCHEDULE_STEAL;
+  p->busy_ns = NULL;
+  p->rows_done = NULL;
+  p->node = NULL;
+}
+
+static void open_gate(struct LifePoolSync *s, int gate) {
+  (void)pthread_mutex_lock(&s->gate_lock);
+  s->gate = gate;
+  (void)pthread_cond_broadcast(&s->gate_cv);
+  (void)pthread_mutex_unlock(&s->gate_lock);
+}
+
+static void sync_destroy(struct LifePoolSync *s) {
+  (void)pthread_barrier_destroy(&s->start);
+  (void)pthread_barrier_destroy(&s->done);
+  (void)pthread_mutex_destroy(&s->gate_lock);
+  (void)pthread_cond_destroy(&s->gate_cv);
+  free(s->threads);
+  free(s->workers);
+  free(s->deques);
+  free(s);
+}
+
+bool life_pool_init(LifePool *p, int nthreads) {
+  if (!p) {
+    return false;
+  }
+  pool_zero(p);
+  const size_t slots = (size_t)((nthreads > 1) ? nthreads : 1);
+  p->busy_ns = (uint64_t *)calloc(slots, sizeof(uint64_t));
+  p->rows_done = (uint64_t *)calloc(slots, sizeof(uint64_t));
+  if (!p->busy_ns || !p->rows_done) {
+    life_pool_free(p);
+    return false;
+  }
+  if (nthreads <= 1) {
+    return true;
+  }
+
+  /* Resolve the kernel before workers read it. */
+  (void)life_active_kernel();
+
+  struct LifePoolSync *s = (struct LifePoolSync *)calloc(1, sizeof(*s));
+  if (!s) {
+    life_pool_free(p);
+    return false;
+  }
+  s->threads = (pthread_t *)calloc((size_t)nthreads, sizeof(pthread_t));
+  s->workers = (LifePoolWorker *)calloc((size_t)nthreads, sizeof(LifePoolWorker));
+  s->deques = (TaskDeque *)calloc((size_t)nthreads, sizeof(TaskDeque));
+  if (!s->threads || !s->workers || !s->deques) {
+    free(s->threads);
+    free(s->workers);
+    free(s->deques);
+    free(s);
+    life_pool_free(p);
+    return false;
+  }
+  if (pthread_barrier_init(&s->start, NULL, (unsigned)nthreads) != 0) {
+    free(s->threads);
+    free(s->workers);
+    free(s->deques);
+    free(s);
+    life_pool_free(p);
+    return false;
+  }
+  if (pthread_barrier_init(&s->done, NULL, (unsigned)nthreads) != 0) {
+    (void)pthread_barrier_destroy(&s->start);
+    free(s->threads);
+    free(s->workers);
+    free(s->deques);
+    free(s);
+    life_pool_free(p);
+    return false;
+  }
+  (void)pthread_mutex_init(&s->gate_lock, NULL);
+  (void)pthread_cond_init(&s->gate_cv, NULL);
+  s->gate = 0;
+
+  p->sync = s;
+  p->nthreads = nthreads;
+
+  int created = 1;
+  for (int i = 1; i < nthreads; i++) {
+    s->workers[i].pool = p;
+    s->workers[i].index = i;
+    if (pthread_create(&s->threads[i], NULL, worker_main, &s->workers[i]) != 0) {
+      break;
+    }
+    created++;
+  }
+
+  if (created < nthreads) {
+    /* The barriers expect nthreads parties: release the workers we have and give up. */
+    open_gate(s, -1);
+    for (int i = 1; i < created; i++) {
+      (void)pthread_join(s->threads[i], NULL);
+    }
+    sync_destroy(s);
+    free(p->busy_ns);
+    free(p->rows_done);
+    pool_zero(p);
+    return false;
+  }
+
+  open_gate(s, 1);
+  return true;
+}
+
+void life_pool_free(LifePool *p) {
+  if (!p) {
+    return;
+  }
+  struct LifePoolSync *s = p->sync;
+  if (s) {
+    p->quit = true;
+    (void)pthread_barrier_wait(&s->start);
+    for (int i = 1; i < p->nthreads; i++) {
+      (void)pthread_join(s->threads[i], NULL);
+    }
+    sync_destroy(s);
+  }
+  free(p->busy_ns);
+  free(p->rows_done);
+  free(p->node);
+  pool_zero(p);
+}
+
+void life_pool_run(LifePool *p, LifePoolRowsFn fn, void *ctx, int rows) {
+  if (!p || !fn || rows <= 0) {
+    return;
+  }
+  if (!p->sync) {
+    const uint64_t t0 = now_ns();
+    fn(ctx, 0, rows);
+    if (p->busy_ns) p->busy_ns[0] += now_ns() - t0;
+    if (p->rows_done) p->rows_done[0] += (uint64_t)rows;
+    return;
+  }
+  p->fn = fn;
+  p->task_fn = NULL;
+  p->ctx = ctx;
+  p->rows = rows;
+  (void)pthread_barrier_wait(&p->sync->start);
+  run_band(p, 0);
+  count_rows(p, 0);
+  (void)pthread_barrier_wait(&p->sync->done);
+}
+
+void life_pool_run_tasks(LifePool *p, LifePoolTaskFn fn, void *ctx, int ntasks) {
+  if (!p || !fn || ntasks <= 0) {
+    return;
+  }
+  if (!p->sync) {
+    const uint64_t t0 = now_ns();
+    for (int i = 0; i < ntasks; i++) {
+      fn(ctx, i, 0);
+    }
+    if (p->busy_ns) p->busy_ns[0] += now_ns() - t0;
+    return;
+  }
+  /* Thread i starts with the contiguous range a band would get; the start barrier publishes it. */
+  for (int i = 0; i < p->nthreads; i++) {
+    const int lo = (int)((long)ntasks * i / p->nthreads);
+    const int hi = (int)((long)ntasks * (i + 1) / p->nthreads);
+    TaskDeque *d = &p->sync->deques[i];
+    atomic_store_explicit(&d->top, lo, memory_order_relaxed);
+    atomic_store_explicit(&d->bottom, hi, memory_order_relaxed);
+    d->mirror = lo + hi - 1;
+  }
+  p->fn = NULL;
+  p->task_fn = fn;
+  p->ctx = ctx;
+  p->rows = ntasks;
+  (void)pthread_barrier_wait(&p->sync->start);
+  run_band(p, 0);
+  (void)pthread_barrier_wait(&p->sync->done);
+}
+
+const char *life_pool_schedule_name(LifePoolSchedule s) {
+  switch (s) {
+    case LIFE_SCHEDULE_STEAL: return "steal";
+    case LIFE_SCHEDULE_STATIC: return "static";
+  }
+  return "?";
+}
+
+bool life_pool_parse_schedule(const char *s, LifePoolSchedule *out) {
+  if (!s || !out) return false;
+  if (strcmp(s, "steal") == 0) {
+    *out = LIFE_SCHEDULE_STEAL;
+  } else if (strcmp(s, "static") == 0) {
+    *out = LIFE_SCHEDULE_STATIC;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+uint64_t life_pool_busy_ns(const LifePool *p, int index) {
+  if (!p || !p->busy_ns || index < 0 || index >= p->nthreads) {
+    return 0;
+  }
+  return p->busy_ns[index];
+}
+
+uint64_t life_pool_rows_done(const LifePool *p, int index) {
+  if (!p || !p->rows_done || index < 0 || index >= p->nthreads) {
+    return 0;
+  }
+  return p->rows_done[index];
+}
+
+void life_pool_reset_stats(LifePool *p) {
+  if (!p || !p->busy_ns || !p->rows_done) {
+    return;
+  }
+  for (int i = 0; i < p->nthreads; i++) {
+    p->busy_ns[i] = 0;
+    p->rows_done[i] = 0;
+  }
+}
+
+typedef struct PinJob {
+  LifePool *pool;
+  const LifeNumaTopology *topo;
+} PinJob;
+
+/* Thread index (band [index, index+1)) pins itself to a CPU of node index * nnodes / nthreads. */
+static void pin_band(void *ctx, int index, int index_end) {
+  (void)index_end;
+  PinJob *job = (PinJob *)ctx;
+  const LifeNumaTopology *t = job->topo;
+  const int n = job->pool->nthreads;
+  const int node = (int)((long)index * t->nnodes / n);
+  const int first = (int)(((long)node * n + t->nnodes - 1) / t->nnodes); /* first thread of the node */
+  const int cpu = t->cpus[t->first_cpu[node] + (index - first) % t->ncpus[node]];
+  job->pool->node[index] = life_numa_pin_self(cpu) ? node : -1;
+}
+
+bool life_pool_pin(LifePool *p) {
+  if (!p || !p->busy_ns) {
+    return false;
+  }
+  if (!p->node) {
+    p->node = (int *)calloc((size_t)p->nthreads, sizeof(int));
+    if (!p->node) {
+      return false;
+    }
+  }
+  PinJob job = {p, life_numa_topology()};
+  life_pool_run(p, pin_band, &job, p->nthreads);
+  bool ok = true;
+  for (int i = 0; i < p->nthreads; i++) {
+    if (p->node[i] < 0) {
+      p->node[i] = 0;
+      ok = false;
+    }
+  }
+  return ok;
+}
+
+int life_pool_node(const LifePool *p, int index) {
+  if (!p || !p->node || index < 0 || index >= p->nthreads) {
+    return 0;
+  }
+  return p->node[index];
+}
+
+typedef struct PlaceJob {
+  uint8_t *base;
+  size_t row_bytes;
+} PlaceJob;
+
+static void place_rows(void *ctx, int y0, int y1) {
+  PlaceJob *job = (PlaceJob *)ctx;
+  memset(job->base + (size_t)y0 * job->row_bytes, 0, (size_t)(y1 - y0) * job->row_bytes);
+}
+
+void life_pool_place(LifePool *p, void *base, size_t row_bytes, int rows) {
+  if (!p || !base || row_bytes == 0 || rows <= 0) {
+    return;
+  }
+  PlaceJob job = {(uint8_t *)base, row_bytes};
+  life_pool_run(p, place_rows, &job, rows);
+}
+
+static void step_rows(void *ctx, int y0, int y1) {
+  StepJob *job = (StepJob *)ctx;
+  life_step_rows(job->cur, job->next, y0, y1);
+}
+
+void life_pool_step(LifePool *p, const Grid *cur, Grid *next) {
+  if (!cur || !next || !cur->cells || !next->cells) {
+    return;
+  }
+  if (cur->w != next->w || cur->h != next->h) {
+    return;
+  }
+  StepJob job = {cur, next};
+  life_pool_run(p, step_rows, &job, cur->h);
+  if (life_boundary() == LIFE_BOUNDARY_TORUS) {
+    grid_wrap_halo(next);
+  }
+}
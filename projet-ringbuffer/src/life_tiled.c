@@ -0,0 +1,174 @@
+#include "life_tiled.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "life.h"
+
+typedef struct TiledJob {
+  LifeTiled *t;
+  const Grid *src;
+  Grid *dst;
+  int tile;
+  int k;
+  int tiles_x;
+  int tiles_y;
+  bool torus;
+} TiledJob;
+
+static int wrap(int v, int n) {
+  v %= n;
+  return (v < 0) ? v + n : v;
+}
+
+/* Copies src cells [gx, gx+n) of row gy into out (dead or wrapped outside the grid). */
+static void load_row(const TiledJob *job, int gy, int gx, int n, uint8_t *out) {
+  const Grid *src = job->src;
+  if (gy < 0 || gy >= src->h) {
+    if (!job->torus) {
+      memset(out, 0, (size_t)n);
+      return;
+    }
+    gy = wrap(gy, src->h);
+  }
+  const uint8_t *row = grid_row(src, gy);
+  int lo = (gx < 0) ? -gx : 0;                          /* first local index inside the grid */
+  int hi = (gx + n > src->w) ? src->w - gx : n;          /* end of the part inside the grid */
+  if (hi < lo) hi = lo;
+  for (int i = 0; i < lo && i < n; i++) {
+    out[i] = job->torus ? row[wrap(gx + i, src->w)] : 0u;
+  }
+  if (hi > lo) {
+    memcpy(out + lo, row + gx + lo, (size_t)(hi - lo));
+  }
+  for (int i = (hi > lo) ? hi : lo; i < n; i++) {
+    out[i] = job->torus ? row[wrap(gx + i, src->w)] : 0u;
+  }
+}
+
+/* Dead boundary: cells of the local buffer lying outside the grid stay dead. */
+static void mask_outside(const TiledJob *job, Grid *local, int gx, int gy) {
+  const Grid *src = job->src;
+  for (int ly = 0; ly < local->h; ly++) {
+    uint8_t *row = grid_row(local, ly);
+    int y = gy + ly;
+    if (y < 0 || y >= src->h) {
+      memset(row, 0, (size_t)local->w);
+      continue;
+    }
+    if (gx < 0) {
+      memset(row, 0, (size_t)((-gx < local->w) ? -gx : local->w));
+    }
+    if (gx + local->w > src->w) {
+      int from = (src->w - gx > 0) ? src->w - gx : 0;
+      memset(row + from, 0, (size_t)(local->w - from));
+    }
+  }
+}
+
+/*
+ * a and b are views of side tile + 2k on the worker's buffers: their right and
+ * bottom halo cells are stale buffer contents, which only spoil the ghost zone.
+ */
+static void run_tile(TiledJob *job, Grid *a, Grid *b, int tx, int ty) {
+  const Grid *src = job->src;
+  const int k = job->k;
+  const int x0 = tx * job->tile;
+  const int y0 = ty * job->tile;
+  const int x1 = (x0 + job->tile < src->w) ? x0 + job->tile : src->w;
+  const int y1 = (y0 + job->tile < src->h) ? y0 + job->tile : src->h;
+  const int gx = x0 - k;
+  const int gy = y0 - k;
+  const bool edge = (gx < 0 || gy < 0 || gx + a->w > src->w || gy + a->h > src->h);
+
+  for (int ly = 0; ly < a->h; ly++) {
+    load_row(job, gy + ly, gx, a->w, grid_row(a, ly));
+  }
+
+  for (int s = 0; s < k; s++) {
+    life_step_rows(a, b, 0, a->h);
+    if (edge && !job->torus) {
+      mask_outside(job, b, gx, gy);
+    }
+    grid_swap(a, b);
+  }
+
+  for (int y = y0; y < y1; y++) {
+    memcpy(grid_row(job->dst, y) + x0, grid_row(a, y - gy) + k, (size_t)(x1 - x0));
+  }
+}
+
+/* Task t: tile (t % tiles_x, t / tiles_x), advanced in the buffers of its worker. */
+static void tiled_task(void *ctx, int task, int worker) {
+  TiledJob *job = (TiledJob *)ctx;
+  const int side = job->tile + 2 * job->k;
+
+  Grid a = job->t->bufs[2 * worker];
+  Grid b = job->t->bufs[2 * worker + 1];
+  a.w = a.h = side;
+  b.w = b.h = side;
+  run_tile(job, &a, &b, task % job->tiles_x, task / job->tiles_x);
+}
+
+bool life_tiled_init(LifeTiled *t, int tile, int max_gens, int nthreads) {
+  if (!t || tile < 1 || max_gens < 1) {
+    return false;
+  }
+  t->tile = tile;
+  t->max_gens = max_gens;
+  t->nbands = (nthreads > 1) ? nthreads : 1;
+  t->bufs = (Grid *)calloc((size_t)t->nbands * 2u, sizeof(Grid));
+  if (!t->bufs) {
+    return false;
+  }
+  /* Dead halo, never written: the outer ring of the buffers stays dead. */
+  const int side = tile + 2 * max_gens;
+  for (int i = 0; i < t->nbands * 2; i++) {
+    if (!grid_create_padded(&t->bufs[i], side, side, 1)) {
+      life_tiled_free(t);
+      return false;
+    }
+  }
+  return true;
+}
+
+void life_tiled_free(LifeTiled *t) {
+  if (!t) return;
+  if (t->bufs) {
+    for (int i = 0; i < t->nbands * 2; i++) {
+      grid_free(&t->bufs[i]);
+    }
+    free(t->bufs);
+  }
+  t->bufs = NULL;
+  t->nbands = 0;
+}
+
+bool life_tiled_pass(LifeTiled *t, LifePool *pool, const Grid *cur, Grid *next, int k) {
+  if (!t || !t->bufs || !cur || !next || !cur->cells || !next->cells) {
+    return false;
+  }
+  if (k < 1 || k > t->max_gens || cur->w != next->w || cur->h != next->h) {
+    return false;
+  }
+  TiledJob job;
+  job.t = t;
+  job.src = cur;
+  job.dst = next;
+  job.tile = t->tile;
+  job.k = k;
+  job.tiles_x = (cur->w + t->tile - 1) / t->tile;
+  job.tiles_y = (cur->h + t->tile - 1) / t->tile;
+  job.torus = (life_boundary() == LIFE_BOUNDARY_TORUS);
+
+  const int ntasks = job.tiles_x * job.tiles_y;
+  if (pool && pool->nthreads > 1 && pool->nthreads == t->nbands) {
+    life_pool_run_tasks(pool, tiled_task, &job, ntasks);
+  } else {
+    for (int i = 0; i < ntasks; i++) {
+      tiled_task(&job, i, 0);
+    }
+  }
+  life_refresh_halo(next);
+  return true;
+}
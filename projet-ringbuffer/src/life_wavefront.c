@@ -0,0 +1,133 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "life_wavefront.h"
+
+#include <sched.h>
+#include <stdlib.h>
+
+#include "life.h"
+
+/* Rows computed by a stage before it publishes its progress (and the lag between stages). */
+enum { WAVE_ROWS = 8 };
+
+typedef struct WaveJob {
+  LifeWavefront *wf;
+  const Grid *src; /* input of stage 0 */
+  int k;
+  int ngroups;
+} WaveJob;
+
+static const Grid *stage_input(const WaveJob *job, int s) {
+  return (s == 0) ? job->src : &job->wf->bufs[s - 1];
+}
+
+/*
+ * Group i of the pool (rows = ngroups => [i, i+1)) runs its stages until each
+ * has written every row. Stage s may compute row y once stage s-1 has finished
+ * row y+1 (the whole grid for the last row).
+ */
+static void wave_group(void *ctx, int group, int group_end) {
+  (void)group_end;
+  WaveJob *job = (WaveJob *)ctx;
+  LifeWavefront *wf = job->wf;
+  const int s0 = (int)((long long)job->k * group / job->ngroups);
+  const int s1 = (int)((long long)job->k * (group + 1) / job->ngroups);
+  const int h = wf->h;
+
+  for (;;) {
+    bool finished = true;
+    bool progressed = false;
+    for (int s = s0; s < s1; s++) {
+      const int y0 = atomic_load_explicit(&wf->done[s], memory_order_relaxed);
+      if (y0 == h) {
+        continue;
+      }
+      finished = false;
+      int limit = h;
+      if (s > 0) {
+        const int prev = atomic_load_explicit(&wf->done[s - 1], memory_order_acquire);
+        limit = (prev == h) ? h : prev - 1;
+      }
+      if (limit <= y0) {
+        continue;
+      }
+      const int y1 = (y0 + WAVE_ROWS < limit) ? y0 + WAVE_ROWS : limit;
+      life_step_rect(stage_input(job, s), &wf->bufs[s], 0, y0, wf->w, y1);
+      atomic_store_explicit(&wf->done[s], y1, memory_order_release);
+      progressed = true;
+    }
+    if (finished) {
+      break;
+    }
+    if (!progressed) {
+      /* Waiting on the previous group's stage. */
+      sched_yield();
+    }
+  }
+}
+
+bool life_wavefront_init(LifeWavefront *wf, int w, int h, int pad, int depth) {
+  if (!wf || w <= 0 || h <= 0 || pad < 1 || depth < 1) {
+    return false;
+  }
+  wf->w = w;
+  wf->h = h;
+  wf->depth = depth;
+  wf->bufs = (Grid *)calloc((size_t)depth, sizeof(Grid));
+  wf->done = (atomic_int *)calloc((size_t)depth, sizeof(atomic_int));
+  if (!wf->bufs || !wf->done) {
+    life_wavefront_free(wf);
+    return false;
+  }
+  /* Dead halo, never written: life_step_rect only writes the cells. */
+  for (int i = 0; i < depth; i++) {
+    if (!grid_create_padded(&wf->bufs[i], w, h, pad)) {
+      life_wavefront_free(wf);
+      return false;
+    }
+  }
+  return true;
+}
+
+void life_wavefront_free(LifeWavefront *wf) {
+  if (!wf) return;
+  if (wf->bufs) {
+    for (int i = 0; i < wf->depth; i++) {
+      grid_free(&wf->bufs[i]);
+    }
+    free(wf->bufs);
+  }
+  free(wf->done);
+  wf->bufs = NULL;
+  wf->done = NULL;
+  wf->depth = 0;
+}
+
+bool life_wavefront_pass(LifeWavefront *wf, LifePool *pool, Grid *g, int k) {
+  if (!wf || !wf->bufs || !g || !g->cells) {
+    return false;
+  }
+  if (k < 1 || k > wf->depth || g->w != wf->w || g->h != wf->h || g->pad != wf->bufs[0].pad) {
+    return false;
+  }
+  if (life_boundary() != LIFE_BOUNDARY_DEAD) {
+    return false;
+  }
+  for (int s = 0; s < k; s++) {
+    atomic_store_explicit(&wf->done[s], 0, memory_order_relaxed);
+  }
+  WaveJob job;
+  job.wf = wf;
+  job.src = g;
+  job.k = k;
+  job.ngroups = (pool && pool->nthreads > 1) ? pool->nthreads : 1;
+
+  if (job.ngroups > 1) {
+    life_pool_run(pool, wave_group, &job, job.ngroups);
+  } else {
+    wave_group(&job, 0, 1);
+  }
+  /* The last stage holds generation +k: trade it for g (same size and halo). */
+  grid_swap(g, &wf->bufs[k - 1]);
+  return true;
+}
@@ -1,3 +1,4 @@
+#include <errno.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
@@ -6,6 +7,7 @@
 
 #include <SDL.h>
 
+#include "engine.h"
 #include "grid.h"
 #include "history.h"
 #include "io.h"
@@ -15,16 +17,19 @@
 typedef struct Args {
   const char *input_path;
   const char *output_path;
-  int steps; /* if >0 and output provided: batch mode without UI */
+  uint64_t steps; /* if >0 and output provided: batch mode without UI */
   int w;
   int h;
-  size_t history_cap; /* ring: max capacity (0 => internal default) */
+  size_t history_cap; /* ring: max capacity (0 => internal default, or what --history-mem allows) */
+  HistoryOptions history; /* ring: snapshot storage */
+  EngineOptions engine; /* batch mode stepping engine */
+  bool rule_given;      /* --rule on the command line (wins over the input file's rule) */
 } Args;
 
 static void usage(const char *prog) {
   fprintf(stderr,
-          "Usage: %s [--input FILE] [--output FILE] [--steps N] [--w W --h H] [--history-cap N]\n",
-          prog ? prog : "life");
+          "Usage: %s [--input FILE] [--output FILE] [--steps N] [--w W --h H] [--history-cap N] %s %s\n",
+          prog ? prog : "life", history_usage(), engine_usage());
 }
 
 static bool parse_int(const char *s, int *out) {
@@ -37,6 +42,17 @@ static bool parse_int(const char *s, int *out) {
   return true;
 }
 
+static bool parse_u64(const char *s, uint64_t *out) {
+  if (!s || !out) return false;
+  if (*s == '-') return false;
+  char *end = NULL;
+  errno = 0;
+  unsigned long long v = strtoull(s, &end, 10);
+  if (end == s || *end != '\0' || errno == ERANGE) return false;
+  *out = (uint64_t)v;
+  return true;
+}
+
 static bool parse_size(const char *s, size_t *out) {
   if (!s || !out) return false;
   char *end = NULL;
@@ -53,15 +69,26 @@ static bool parse_args(int argc, char **argv, Args *a) {
   a->steps = 0;
   a->w = 0;
   a->h = 0;
-  a->history_cap = 512;
+  a->history_cap = 0;
+  history_options_default(&a->history);
+  engine_options_default(&a->engine);
+  a->rule_given = false;
 
   for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--rule") == 0) {
+      a->rule_given = true;
+    }
+    int r = engine_parse_arg(&a->engine, argc, argv, &i);
+    if (r == 0) r = history_parse_arg(&a->history, argc, argv, &i);
+    if (r < 0) return false;
+    if (r > 0) continue;
+
     if (strcmp(argv[i], "--input") == 0 && i + 1 < argc) {
       a->input_path = argv[++i];
     } else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
       a->output_path = argv[++i];
     } else if (strcmp(argv[i], "--steps") == 0 && i + 1 < argc) {
-      if (!parse_int(argv[++i], &a->steps) || a->steps < 0) return false;
+      if (!parse_u64(argv[++i], &a->steps)) return false;
     } else if (strcmp(argv[i], "--w") == 0 && i + 1 < argc) {
       if (!parse_int(argv[++i], &a->w) || a->w < 1) return false;
     } else if (strcmp(argv[i], "--h") == 0 && i + 1 < argc) {
@@ -114,15 +141,45 @@ static void prompt_path(const char *label, char *out, size_t outcap, const char
   }
 }
 
-static bool do_step_and_push(History *hist, Grid *scratch_next) {
-  Grid *cur = history_current(hist);
-  if (!cur || !scratch_next) return false;
-  if (scratch_next->cells == NULL || scratch_next->w != cur->w || scratch_next->h != cur->h) {
-    grid_free(scratch_next);
-    if (!grid_create(scratch_next, cur->w, cur->h)) return false;
+/* Reads a generation number in [first, last]; false on empty input or out of range. */
+static bool prompt_gen(uint64_t *out, uint64_t first, uint64_t last) {
+  char buf[64];
+  fprintf(stdout, "Aller à la génération [%llu-%llu]: ", (unsigned long long)first, (unsigned long long)last);
+  fflush(stdout);
+  if (!fgets(buf, (int)sizeof(buf), stdin)) {
+    return false;
+  }
+  size_t n = strlen(buf);
+  if (n > 0 && (buf[n - 1] == '\n' || buf[n - 1] == '\r')) buf[n - 1] = '\0';
+  uint64_t v = 0;
+  if (buf[0] == '\0') {
+    return false;
   }
-  life_step(cur, scratch_next);
-  return history_push(hist, scratch_next);
+  if (!parse_u64(buf, &v) || v < first || v > last) {
+    fprintf(stderr, "Génération invalide: '%s' (historique: %llu-%llu)\n", buf, (unsigned long long)first,
+            (unsigned long long)last);
+    return false;
+  }
+  *out = v;
+  return true;
+}
+
+static bool do_step_and_push(History *hist) {
+  Grid *cur = history_current(hist);
+  Grid *next = history_reserve(hist);
+  if (!cur || !next) return false;
+  life_step(cur, next);
+  return history_commit(hist);
+}
+
+/* Title bar (generation, position in the history and its memory use) and timeline. */
+static void show_history(UiSdl *ui, const History *hist) {
+  char status[160];
+  (void)snprintf(status, sizeof(status), "gen %llu (%zu/%zu) - historique %.1f Mo (pic %.1f Mo)",
+                 (unsigned long long)history_generation(hist), hist->cur + 1, hist->len,
+                 (double)history_bytes(hist) / 1e6, (double)history_peak_bytes(hist) / 1e6);
+  ui_set_status(ui, status);
+  ui_set_timeline(ui, history_first_generation(hist), history_generation(hist), history_last_generation(hist));
 }
 
 int main(int argc, char **argv) {
@@ -131,19 +188,24 @@ int main(int argc, char **argv) {
     usage(argv[0]);
     return 2;
   }
+  grid_set_pages(args.engine.pages);
 
   fprintf(stdout,
-          "Contrôles: [Espace]=play/pause, N=step, B=back, F=forward, S=save, R=resize, Q/Echap=quit\n");
+          "Contrôles: [Espace]=play/pause, N=step, B=back, F=forward, G=aller à, S=save, R=resize, Q/Echap=quit\n");
   fflush(stdout);
 
   Grid g0 = {0};
   char err[256];
 
   if (args.input_path) {
-    if (!grid_load_from_file(args.input_path, &g0, err, sizeof(err))) {
+    LifeRule file_rule = args.engine.rule;
+    if (!grid_load_with_rule(args.input_path, &g0, &file_rule, err, sizeof(err))) {
       fprintf(stderr, "Erreur chargement '%s': %s\n", args.input_path, err);
       return 1;
     }
+    if (!args.rule_given) {
+      args.engine.rule = file_rule;
+    }
   } else {
     int w = (args.w > 0) ? args.w : 50;
     int h = (args.h > 0) ? args.h : 30;
@@ -159,42 +221,81 @@ int main(int argc, char **argv) {
   /* Batch mode: --steps N and --output PATH => compute without SDL then save. */
   if (args.steps > 0 && args.output_path) {
     Grid cur = {0};
-    Grid next = {0};
-    if (!grid_create(&cur, g0.w, g0.h) || !grid_create(&next, g0.w, g0.h)) {
+    Engine eng;
+    if (!grid_create_padded(&cur, g0.w, g0.h, 1)) {
       fprintf(stderr, "Allocation échouée (batch)\n");
       grid_free(&g0);
+      return 1;
+    }
+    if (!engine_supports_boundary(args.engine.kind, args.engine.boundary)) {
+      fprintf(stderr, "Moteur '%s' incompatible avec --boundary %s\n", engine_kind_name(args.engine.kind),
+              life_boundary_name(args.engine.boundary));
+      grid_free(&g0);
+      grid_free(&cur);
+      return 1;
+    }
+    if (!engine_init(&eng, &args.engine, g0.w, g0.h)) {
+      fprintf(stderr, "Init moteur '%s' échouée\n", engine_kind_name(args.engine.kind));
+      grid_free(&g0);
       grid_free(&cur);
-      grid_free(&next);
       return 1;
     }
-    memcpy(cur.cells, g0.cells, (size_t)g0.w * (size_t)g0.h);
+    (void)grid_copy(&cur, &g0);
 
-    for (int i = 0; i < args.steps; i++) {
-      life_step(&cur, &next);
-      grid_swap(&cur, &next);
+    if (!engine_run(&eng, &cur, args.steps)) {
+      if (args.engine.kind == ENGINE_HASHLIFE && eng.hl.error == HASHLIFE_TOO_FAR) {
+        fprintf(stderr, "Moteur 'hashlife': le motif sort du plan représentable (2^62 cellules de côté) après %llu générations\n",
+                (unsigned long long)eng.hl.generation);
+      } else if (args.engine.kind == ENGINE_HASHLIFE && eng.hl.error == HASHLIFE_NO_MEMORY) {
+        fprintf(stderr, "Moteur 'hashlife': mémoire épuisée après %llu générations\n",
+                (unsigned long long)eng.hl.generation);
+      } else {
+        fprintf(stderr, "Moteur '%s': calcul échoué\n", engine_kind_name(args.engine.kind));
+      }
+      engine_free(&eng);
+      grid_free(&g0);
+      grid_free(&cur);
+      return 1;
+    }
+    uint64_t period = 0, start = 0;
+    if (engine_cycle(&eng, &period, &start)) {
+      fprintf(stderr, "Cycle de période %llu détecté à la génération %llu (avance rapide)\n",
+              (unsigned long long)period, (unsigned long long)start);
     }
+    engine_free(&eng);
+
     if (!grid_save_to_file(args.output_path, &cur, err, sizeof(err))) {
       fprintf(stderr, "Erreur sauvegarde '%s': %s\n", args.output_path, err);
       grid_free(&g0);
       grid_free(&cur);
-      grid_free(&next);
       return 1;
     }
     grid_free(&g0);
     grid_free(&cur);
-    grid_free(&next);
     return 0;
   }
 
+  /* One-cell halo: the kernels read neighbors without bounds checks. */
+  if (!grid_set_pad(&g0, 1)) {
+    fprintf(stderr, "Allocation grille échouée (halo)\n");
+    grid_free(&g0);
+    return 1;
+  }
+  if (!engine_configure(&args.engine)) {
+    fprintf(stderr, "Noyau '%s' non supporté par ce CPU\n", life_kernel_name(args.engine.kernel));
+    grid_free(&g0);
+    return 1;
+  }
+  life_refresh_halo(&g0);
+
   History hist;
-  if (!history_init(&hist, &g0, args.history_cap)) {
+  if (!history_init_with(&hist, &g0, args.history_cap, &args.history)) {
     fprintf(stderr, "Init historique échouée\n");
     grid_free(&g0);
     return 1;
   }
   grid_free(&g0);
 
-  Grid scratch_next = {0};
   bool playing = (args.input_path != NULL);
   uint32_t last_tick = 0;
   const uint32_t step_ms = 120;
@@ -205,17 +306,19 @@ int main(int argc, char **argv) {
     history_free(&hist);
     return 1;
   }
+  show_history(&ui, &hist);
 
   bool quit = false;
   while (!quit) {
-    UiAction act = ui_poll_action(&quit);
+    UiAction act = ui_poll_action(&ui, &quit);
+    bool changed = (act != UI_ACT_NONE);
     if (act == UI_ACT_QUIT) {
       quit = true;
     } else if (act == UI_ACT_TOGGLE_PLAY) {
       playing = !playing;
     } else if (act == UI_ACT_STEP) {
       playing = false;
-      if (!do_step_and_push(&hist, &scratch_next)) {
+      if (!do_step_and_push(&hist)) {
         fprintf(stderr, "Step: échec (allocation/historique)\n");
       }
     } else if (act == UI_ACT_BACK) {
@@ -224,6 +327,16 @@ int main(int argc, char **argv) {
     } else if (act == UI_ACT_FORWARD) {
       playing = false;
       (void)history_forward(&hist);
+    } else if (act == UI_ACT_GOTO) {
+      playing = false;
+      uint64_t gen = 0;
+      if (prompt_gen(&gen, history_first_generation(&hist), history_last_generation(&hist)) &&
+          !history_seek(&hist, gen)) {
+        fprintf(stderr, "Génération %llu: lecture échouée\n", (unsigned long long)gen);
+      }
+    } else if (act == UI_ACT_SEEK) {
+      playing = false;
+      (void)history_seek(&hist, ui.seek_gen);
     } else if (act == UI_ACT_SAVE) {
       playing = false;
       char path[512];
@@ -246,14 +359,14 @@ int main(int argc, char **argv) {
         fprintf(stderr, "Resize: realloc échoué (%d x %d)\n", nw, nh);
         grid_destroy(resized);
       } else {
+        life_refresh_halo(resized);
         History new_hist;
-        if (!history_init(&new_hist, resized, args.history_cap)) {
+        if (!history_init_with(&new_hist, resized, args.history_cap, &args.history)) {
           fprintf(stderr, "Resize: init historique échouée\n");
         } else {
           history_free(&hist);
           hist = new_hist;
-          grid_free(&scratch_next);
-          fprintf(stdout, "Resize OK -> %d x %d (historique réinitialisé)\n", nw, nh);
+          fprintf(stdout, "Resize OK -> %d x %d (historique réinitialisé, capacité %zu)\n", nw, nh, hist.cap);
           fflush(stdout);
         }
         grid_destroy(resized);
@@ -264,19 +377,22 @@ int main(int argc, char **argv) {
       uint32_t now = SDL_GetTicks();
       if (now - last_tick >= step_ms) {
         last_tick = now;
-        if (!do_step_and_push(&hist, &scratch_next)) {
+        if (!do_step_and_push(&hist)) {
           fprintf(stderr, "Play: step échoué (allocation/historique)\n");
           playing = false;
         }
+        changed = true;
       }
     }
+    if (changed) {
+      show_history(&ui, &hist);
+    }
 
     ui_render_grid(&ui, history_current_const(&hist));
     SDL_Delay(10);
   }
 
   ui_shutdown(&ui);
-  grid_free(&scratch_next);
   history_free(&hist);
   return 0;
 }
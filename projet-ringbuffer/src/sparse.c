@@ -0,0 +1,205 @@
+#include "sparse.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "life.h"
+
+#define SPARSE_EMPTY UINT64_MAX
+
+enum { SPARSE_MIN_TABLE = 1 << 10, SPARSE_ALIVE = 16 };
+
+static inline uint64_t cell_key(int x, int y) {
+  return ((uint64_t)(uint32_t)y << 32) | (uint32_t)x;
+}
+
+/*
+ * The 8x8 block of a cell picks a region of 128 slots and the cell its own
+ * even slot in it: a cell and its neighbors mostly share one or two regions
+ * (cache friendly), and cells of one block never collide with each other.
+ */
+static inline size_t key_hash(uint64_t k, size_t mask) {
+  const uint64_t block = (k >> 3) & 0x1fffffff1fffffffull;
+  uint64_t h = block * 0x9e3779b97f4a7c15ull;
+  h ^= h >> 32;
+  const size_t in_block = (size_t)((((k >> 32) & 7u) << 4) | ((k & 7u) << 1));
+  return (((size_t)h << 7) | in_block) & mask;
+}
+
+static bool reserve(uint64_t **buf, size_t *cap, size_t n) {
+  if (n <= *cap) {
+    return true;
+  }
+  size_t c = *cap ? *cap : 256u;
+  while (c < n) {
+    c *= 2u;
+  }
+  uint64_t *p = (uint64_t *)realloc(*buf, c * sizeof(uint64_t));
+  if (!p) {
+    return false;
+  }
+  *buf = p;
+  *cap = c;
+  return true;
+}
+
+bool sparse_init(SparseLife *s, int w, int h) {
+  if (!s || w <= 0 || h <= 0) {
+    return false;
+  }
+  memset(s, 0, sizeof(*s));
+  s->w = w;
+  s->h = h;
+  return true;
+}
+
+void sparse_free(SparseLife *s) {
+  if (!s) return;
+  free(s->cells);
+  free(s->scratch);
+  free(s->keys);
+  free(s->counts);
+  memset(s, 0, sizeof(*s));
+}
+
+bool sparse_load(SparseLife *s, const Grid *g) {
+  if (!s || !g || !g->cells || g->w != s->w || g->h != s->h) {
+    return false;
+  }
+  s->count = 0;
+  for (int y = 0; y < g->h; y++) {
+    const uint8_t *row = grid_row(g, y);
+    const uint8_t *p = row;
+    const uint8_t *end = row + g->w;
+    while ((p = (const uint8_t *)memchr(p, 1, (size_t)(end - p))) != NULL) {
+      if (!reserve(&s->cells, &s->cap, s->count + 1u)) {
+        return false;
+      }
+      s->cells[s->count++] = cell_key((int)(p - row), y);
+      p++;
+    }
+  }
+  return true;
+}
+
+bool sparse_store(const SparseLife *s, Grid *g) {
+  if (!s || !g || !g->cells || g->w != s->w || g->h != s->h) {
+    return false;
+  }
+  grid_clear(g);
+  for (size_t i = 0; i < s->count; i++) {
+    uint64_t k = s->cells[i];
+    grid_row(g, (int)(k >> 32))[(uint32_t)k] = 1u;
+  }
+  return true;
+}
+
+/* Table of at least 2 slots per candidate cell (9 per live cell), emptied. */
+static bool table_prepare(SparseLife *s) {
+  size_t want = SPARSE_MIN_TABLE;
+  while (want < s->count * 18u) {
+    want *= 2u;
+  }
+  /* Regrow, or shrink once the population has collapsed (clearing costs the table size). */
+  if (want > s->table_size || want * 64u < s->table_size) {
+    uint64_t *keys = (uint64_t *)malloc(want * sizeof(uint64_t));
+    uint8_t *counts = (uint8_t *)malloc(want);
+    if (!keys || !counts) {
+      free(keys);
+      free(counts);
+      return false;
+    }
+    free(s->keys);
+    free(s->counts);
+    s->keys = keys;
+    s->counts = counts;
+    s->table_size = want;
+  }
+  memset(s->keys, 0xff, s->table_size * sizeof(uint64_t));
+  return true;
+}
+
+static inline void table_add(SparseLife *s, uint64_t k, uint8_t v) {
+  const size_t mask = s->table_size - 1u;
+  size_t i = key_hash(k, mask);
+  while (s->keys[i] != k) {
+    if (s->keys[i] == SPARSE_EMPTY) {
+      s->keys[i] = k;
+      s->counts[i] = v;
+      return;
+    }
+    i = (i + 1u) & mask;
+  }
+  s->counts[i] = (uint8_t)(s->counts[i] + v);
+}
+
+static bool sparse_step(SparseLife *s, bool torus, const LifeRule *rule) {
+  if (!table_prepare(s)) {
+    return false;
+  }
+  const int w = s->w;
+  const int h = s->h;
+  for (size_t i = 0; i < s->count; i++) {
+    const uint64_t k = s->cells[i];
+    const int x = (int)(uint32_t)k;
+    const int y = (int)(k >> 32);
+    table_add(s, k, SPARSE_ALIVE);
+    for (int dy = -1; dy <= 1; dy++) {
+      int ny = y + dy;
+      if (ny < 0 || ny >= h) {
+        if (!torus) continue;
+        ny = (ny < 0) ? h - 1 : 0;
+      }
+      for (int dx = -1; dx <= 1; dx++) {
+        if (dx == 0 && dy == 0) {
+          continue;
+        }
+        int nx = x + dx;
+        if (nx < 0 || nx >= w) {
+          if (!torus) continue;
+          nx = (nx < 0) ? w - 1 : 0;
+        }
+        table_add(s, cell_key(nx, ny), 1u);
+      }
+    }
+  }
+
+  size_t n = 0;
+  for (size_t i = 0; i < s->table_size; i++) {
+    if (s->keys[i] == SPARSE_EMPTY) {
+      continue;
+    }
+    const uint8_t c = s->counts[i];
+    const uint8_t neighbors = c & 15u;
+    if ((c & SPARSE_ALIVE) ? rule->survive[neighbors] : rule->birth[neighbors]) {
+      if (!reserve(&s->scratch, &s->scratch_cap, n + 1u)) {
+        return false;
+      }
+      s->scratch[n++] = s->keys[i];
+    }
+  }
+
+  uint64_t *tmp = s->cells;
+  size_t tmp_cap = s->cap;
+  s->cells = s->scratch;
+  s->cap = s->scratch_cap;
+  s->count = n;
+  s->scratch = tmp;
+  s->scratch_cap = tmp_cap;
+  return true;
+}
+
+bool sparse_advance(SparseLife *s, uint64_t steps) {
+  if (!s) {
+    return false;
+  }
+  const bool torus = (life_boundary() == LIFE_BOUNDARY_TORUS);
+  const LifeRule *rule = life_rule();
+  /* An empty world stays empty (no B0 rule). */
+  for (uint64_t i = 0; i < steps && s->count > 0; i++) {
+    if (!sparse_step(s, torus, rule)) {
+      return false;
+    }
+  }
+  return true;
+}
@@ -2,6 +2,9 @@
 
 #include <stdio.h>
 
+/* Timeline bar: height and side margin, in pixels. */
+enum { TIMELINE_H = 14, TIMELINE_MARGIN = 8 };
+
 static void color_alive(SDL_Renderer *ren) {
   /* green/blue */
   (void)SDL_SetRenderDrawColor(ren, 60, 220, 160, 255);
@@ -23,13 +26,19 @@ bool ui_init(UiSdl *ui, const char *title, int win_w, int win_h) {
   ui->ren = NULL;
   ui->win_w = win_w;
   ui->win_h = win_h;
+  ui->tl_first = 0;
+  ui->tl_cur = 0;
+  ui->tl_last = 0;
+  ui->tl_drag = false;
+  ui->seek_gen = 0;
+  (void)snprintf(ui->title, sizeof(ui->title), "%s", title ? title : "Jeu de la vie");
 
   if (SDL_Init(SDL_INIT_VIDEO) != 0) {
     fprintf(stderr, "SDL_Init: %s\n", SDL_GetError());
     return false;
   }
 
-  ui->win = SDL_CreateWindow(title ? title : "Jeu de la vie",
+  ui->win = SDL_CreateWindow(ui->title,
                              SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
                              win_w, win_h, SDL_WINDOW_SHOWN | SDL_WINDOW_RESIZABLE);
   if (!ui->win) {
@@ -50,6 +59,19 @@ bool ui_init(UiSdl *ui, const char *title, int win_w, int win_h) {
   return true;
 }
 
+void ui_set_status(UiSdl *ui, const char *status) {
+  if (!ui || !ui->win) {
+    return;
+  }
+  char buf[sizeof(ui->title) + 160];
+  if (status && status[0]) {
+    (void)snprintf(buf, sizeof(buf), "%s - %s", ui->title, status);
+  } else {
+    (void)snprintf(buf, sizeof(buf), "%s", ui->title);
+  }
+  SDL_SetWindowTitle(ui->win, buf);
+}
+
 void ui_shutdown(UiSdl *ui) {
   if (!ui) {
     return;
@@ -65,6 +87,49 @@ void ui_shutdown(UiSdl *ui) {
   SDL_Quit();
 }
 
+void ui_set_timeline(UiSdl *ui, uint64_t first, uint64_t cur, uint64_t last) {
+  if (!ui) {
+    return;
+  }
+  ui->tl_first = first;
+  ui->tl_cur = cur;
+  ui->tl_last = last;
+}
+
+static bool timeline_shown(const UiSdl *ui) {
+  return ui->tl_last > ui->tl_first;
+}
+
+/* Generation under window column x (clamped to the stored range). */
+static uint64_t timeline_gen(const UiSdl *ui, int x, int win_w) {
+  const int len = win_w - 2 * TIMELINE_MARGIN;
+  if (len <= 1 || x <= TIMELINE_MARGIN) {
+    return ui->tl_first;
+  }
+  if (x >= TIMELINE_MARGIN + len - 1) {
+    return ui->tl_last;
+  }
+  const double f = (double)(x - TIMELINE_MARGIN) / (double)(len - 1);
+  return ui->tl_first + (uint64_t)(f * (double)(ui->tl_last - ui->tl_first) + 0.5);
+}
+
+static void render_timeline(UiSdl *ui, int w, int h) {
+  const int len = w - 2 * TIMELINE_MARGIN;
+  if (len <= 1) {
+    return;
+  }
+  const double f = (double)(ui->tl_cur - ui->tl_first) / (double)(ui->tl_last - ui->tl_first);
+  const int x = TIMELINE_MARGIN + (int)(f * (double)(len - 1) + 0.5);
+  SDL_Rect track = {TIMELINE_MARGIN, h - TIMELINE_H + 5, len, TIMELINE_H - 10};
+  color_gridline(ui->ren);
+  (void)SDL_RenderFillRect(ui->ren, &track);
+  SDL_Rect done = {TIMELINE_MARGIN, track.y, x - TIMELINE_MARGIN + 1, track.h};
+  color_alive(ui->ren);
+  (void)SDL_RenderFillRect(ui->ren, &done);
+  SDL_Rect knob = {x - 2, h - TIMELINE_H + 1, 5, TIMELINE_H - 2};
+  (void)SDL_RenderFillRect(ui->ren, &knob);
+}
+
 void ui_render_grid(UiSdl *ui, const Grid *g) {
   if (!ui || !ui->ren || !ui->win || !g || !g->cells || g->w <= 0 || g->h <= 0) {
     return;
@@ -78,6 +143,10 @@ void ui_render_grid(UiSdl *ui, const Grid *g) {
 
   color_dead(ui->ren);
   (void)SDL_RenderClear(ui->ren);
+  const int win_h = h;
+  if (timeline_shown(ui) && h > 2 * TIMELINE_H) {
+    h -= TIMELINE_H;
+  }
 
   int cell_w = w / g->w;
   int cell_h = h / g->h;
@@ -120,10 +189,35 @@ void ui_render_grid(UiSdl *ui, const Grid *g) {
     }
   }
 
+  if (win_h != h) {
+    render_timeline(ui, w, win_h);
+  }
+
   SDL_RenderPresent(ui->ren);
 }
 
-UiAction ui_poll_action(bool *out_quit) {
+/* Click or drag at (x, y): UI_ACT_SEEK if it concerns the timeline. */
+static UiAction timeline_mouse(UiSdl *ui, int x, int y, bool press) {
+  if (!ui || !ui->win || !timeline_shown(ui)) {
+    return UI_ACT_NONE;
+  }
+  int w = 0, h = 0;
+  SDL_GetWindowSize(ui->win, &w, &h);
+  if (press) {
+    ui->tl_drag = (h > 2 * TIMELINE_H && y >= h - TIMELINE_H);
+  }
+  if (!ui->tl_drag) {
+    return UI_ACT_NONE;
+  }
+  const uint64_t gen = timeline_gen(ui, x, w);
+  if (!press && gen == ui->seek_gen) {
+    return UI_ACT_NONE;
+  }
+  ui->seek_gen = gen;
+  return UI_ACT_SEEK;
+}
+
+UiAction ui_poll_action(UiSdl *ui, bool *out_quit) {
   if (out_quit) {
     *out_quit = false;
   }
@@ -146,6 +240,18 @@ UiAction ui_poll_action(bool *out_quit) {
       if (k == SDLK_f) return UI_ACT_FORWARD;
       if (k == SDLK_s) return UI_ACT_SAVE;
       if (k == SDLK_r) return UI_ACT_RESIZE;
+      if (k == SDLK_g) return UI_ACT_GOTO;
+    }
+    if (e.type == SDL_MOUSEBUTTONDOWN && e.button.button == SDL_BUTTON_LEFT) {
+      const UiAction a = timeline_mouse(ui, e.button.x, e.button.y, true);
+      if (a != UI_ACT_NONE) return a;
+    }
+    if (e.type == SDL_MOUSEMOTION && (e.motion.state & SDL_BUTTON_LMASK)) {
+      const UiAction a = timeline_mouse(ui, e.motion.x, e.motion.y, false);
+      if (a != UI_ACT_NONE) return a;
+    }
+    if (e.type == SDL_MOUSEBUTTONUP && e.button.button == SDL_BUTTON_LEFT && ui) {
+      ui->tl_drag = false;
     }
   }
   return UI_ACT_NONE;